@@ -142,6 +142,10 @@ void POSTalt()
   PrimaryRadio.preinit(NULL);
   // Check that the radio is correctly connected; panic if not...
   if(!PrimaryRadio.configure(1, &RFMConfig) || !PrimaryRadio.begin()) { panic(F("r1")); }
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+  // Timestamp RX frames for relay latency, and shed them at the ISR while the uplink is lagging.
+  PrimaryRadio.setFilterRXISR(FrameRelay::filterRXISR);
+#endif
 #endif
 
 
@@ -292,7 +296,7 @@ void loopAlt()
 #endif
 
 #if !defined(ENABLE_MIN_ENERGY_BOOT)
-  OTV0P2BASE::powerDownSerial(); // Ensure that serial I/O is off.
+  SerialSession::endCycle(); // Ensure that serial I/O is drained and off.
   // Power down most stuff (except radio for hub RX).
   OTV0P2BASE::minimisePowerWithoutSleep();
 #endif
@@ -319,7 +323,11 @@ void loopAlt()
       // No h/w interrupt wakeup on receipt of frame,
       // so can only sleep for a short time between explicit poll()s,
       // though allow wake on interrupt anyway to minimise loop timing jitter.
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+      RXPoll.napAndAdapt(&PrimaryRadio);
+#else
       OTV0P2BASE::nap(WDTO_15MS, true);
+#endif
       }
     else
       {
@@ -333,6 +341,19 @@ void loopAlt()
 
     }
   TIME_LSD = newTLSD;
+#if !defined(ENABLE_MIN_ENERGY_BOOT)
+  SerialSession::beginCycle();
+#endif
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+  Relay.tickCycle();
+  // Report relay throughput and latency once per hour.
+  if((0 == TIME_LSD) && (0 == OTV0P2BASE::getMinutesLT()))
+    {
+    SerialSession session;
+    Relay.report(&Serial);
+    OTV0P2BASE::flushSerialSCTSensitive();
+    }
+#endif
 
 #if 1 && defined(DEBUG)
   DEBUG_SERIAL_PRINTLN_FLASHSTRING("*S"); // Start-of-cycle wake.
@@ -21,6 +21,7 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2016
  Control/model for TRV and boiler.
  */
 #include <util/atomic.h>
+#include <avr/sleep.h>
 
 #include "V0p2_Main.h"
 
@@ -45,6 +46,27 @@ SimpleValveSchedule Scheduler;
 static bool isBoilerOn();
 #endif
 
+#if defined(ENABLE_URGENT_STATS_TX)
+// Set when a user action or large valve move should be reported without waiting for the usual stats slot.
+// Checked every cycle after sensor and UI handling, and cleared by any stats TX.
+// Marked volatile to allow atomic access from ISR without a lock.
+static volatile bool urgentStatsTXPending;
+// Valve position as of the last stats TX, to spot large moves not yet reported.
+static uint8_t urgentStatsTXLastValvePC;
+// Target temperature as of the last stats TX, to spot user adjustments not yet reported.
+static uint8_t urgentStatsTXLastTargetC;
+// Minutes before another urgent stats TX is allowed, to bound extra radio traffic.
+static uint8_t urgentStatsTXHoldoffM;
+// Minimum minutes between urgent stats TXes.
+static const uint8_t URGENT_STATS_TX_MIN_GAP_M = 2;
+// Valve move (percentage points) since the last stats TX that is large enough to report promptly.
+static const uint8_t URGENT_STATS_TX_VALVE_DELTA_PC = 25;
+// Request a stats TX within the current cycle if possible; ISR-safe.
+static inline void requestUrgentStatsTX() { urgentStatsTXPending = true; }
+#else
+static inline void requestUrgentStatsTX() { }
+#endif // defined(ENABLE_URGENT_STATS_TX)
+
 // If true then is in WARM (or BAKE) mode; defaults to (starts as) false/FROST.
 // Should be only be set when 'debounced'.
 // Defaults to (starts as) false/FROST.
@@ -63,8 +85,8 @@ void setWarmModeDebounced(const bool warm)
 // Start/cancel WARM mode in one call, driven by manual UI input.
 static void setWarmModeFromManualUI(const bool warm)
   {
-  // Give feedback when changing WARM mode.
-  if(inWarmMode() != warm) { markUIControlUsedSignificant(); }
+  // Give feedback when changing WARM mode, and report it promptly.
+  if(inWarmMode() != warm) { markUIControlUsedSignificant(); requestUrgentStatsTX(); }
   // Now set/cancel WARM.
   setWarmModeDebounced(warm);
   }
@@ -81,7 +103,7 @@ void cancelBakeDebounced() { bakeCountdownM = 0; }
 // Start/restart 'BAKE' mode and timeout.
 // Should ideally be only be called once 'debounced' if coming from a button press for example.
 // Is thread-/ISR- safe.
-void startBake() { isWarmMode = true; bakeCountdownM = BAKE_MAX_M; }
+void startBake() { isWarmMode = true; bakeCountdownM = BAKE_MAX_M; requestUrgentStatsTX(); }
 #if defined(ENABLE_SIMPLIFIED_MODE_BAKE)
 // Start BAKE from manual UI interrupt; marks UI as used also.
 // Vetos switch to BAKE mode if a temp pot/dial is present and at the low end stop, ie in FROST position.
@@ -363,28 +385,55 @@ uint8_t ModelledRadValve::mVPRO_cache = 0;
 
 // Return minimum valve percentage open to be considered actually/significantly open; [1,100].
 // At the boiler hub this is also the threshold percentage-open on eavesdropped requests that will call for heat.
-// If no override is set then OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN is used.
+// If no override is set then any learned value else OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN is used.
 // NOTE: raising this value temporarily (and shutting down the boiler immediately if possible) is one way to implement dynamic demand.
 uint8_t ModelledRadValve::getMinValvePcReallyOpen()
   {
   if(0 != mVPRO_cache) { return(mVPRO_cache); } // Return cached value if possible.
   const uint8_t stored = eeprom_read_byte((uint8_t *)V0P2BASE_EE_START_MIN_VALVE_PC_REALLY_OPEN);
-  const uint8_t result = ((stored > 0) && (stored <= 100)) ? stored : OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN;
+  const bool isSet = (stored > 0) && (stored <= 100);
+  uint8_t result = isSet ? stored : OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN;
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+  // A manual value always takes precedence over a learned one.
+  if(!isSet)
+    {
+    const uint8_t learned = eeprom_read_byte((uint8_t *)V0P2_EE_START_LEARNED_MIN_VALVE_PC_REALLY_OPEN);
+    // Ignore anything above the calibrator's cap, eg persisted under an older, higher cap.
+    if((learned > 0) && (learned <= MinOpenCalibrator::MAX_PC)) { result = learned; }
+    }
+#endif
   mVPRO_cache = result; // Cache it.
   return(result);
   }
 
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+// Store the learned minimum valve percentage open, used while no override is set.
+void ModelledRadValve::setLearnedMinValvePcReallyOpen(const uint8_t percent)
+  {
+  if((percent == 0) || (percent > 100)) { return; }
+  OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_LEARNED_MIN_VALVE_PC_REALLY_OPEN, percent);
+  mVPRO_cache = 0; // Force reload.
+  }
+#endif
+
 // Set and cache minimum valve percentage open to be considered really open.
 // Applies to local valve and, at hub, to calls for remote calls for heat.
-// Any out-of-range value (eg >100) clears the override and OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN will be used.
+// Any out-of-range value (0 or >100) clears the override and then any learned value
+// else OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN will be used;
+// any other value is kept as an override even if equal to the default.
 void ModelledRadValve::setMinValvePcReallyOpen(const uint8_t percent)
   {
-  if((percent > 100) || (percent == 0) || (percent == OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN))
+  if((percent > 100) || (percent == 0))
     {
-    // Bad / out-of-range / default value so erase stored value if not already so.
+    // Bad / out-of-range value so erase stored value if not already so.
     OTV0P2BASE::eeprom_smart_erase_byte((uint8_t *)V0P2BASE_EE_START_MIN_VALVE_PC_REALLY_OPEN);
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+    // Force reload, falling back to any learned value.
+    mVPRO_cache = 0;
+#else
     // Cache logical default value.
     mVPRO_cache = OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN;
+#endif
     return;
     }
   // Store specified value with as low wear as possible.
@@ -393,6 +442,39 @@ void ModelledRadValve::setMinValvePcReallyOpen(const uint8_t percent)
   mVPRO_cache = percent;
   }
 
+// Cache initially unset.
+uint8_t ModelledRadValve::mVPMO_cache = 0;
+
+// Get maximum allowed percent open [1,100] to limit maximum flow rate.
+uint8_t ModelledRadValve::getMaxPercentageOpenAllowed()
+  {
+  if(0 == mVPMO_cache)
+    {
+    const uint8_t stored = eeprom_read_byte((uint8_t *)V0P2_EE_START_MAX_VALVE_PC_OPEN);
+    mVPMO_cache = ((stored >= MIN_MAX_PC_OPEN) && (stored < 100)) ? stored : 100;
+    }
+#if defined(TRV_MAX_PC_OPEN)
+  return(OTV0P2BASE::fnmin(mVPMO_cache, (uint8_t)TRV_MAX_PC_OPEN));
+#else
+  return(mVPMO_cache);
+#endif
+  }
+
+// Set and cache the maximum allowed percent open; 0 or >= 100 clears the limit.
+bool ModelledRadValve::setMaxPercentageOpenAllowed(const uint8_t percent)
+  {
+  if((0 == percent) || (percent >= 100))
+    {
+    OTV0P2BASE::eeprom_smart_erase_byte((uint8_t *)V0P2_EE_START_MAX_VALVE_PC_OPEN);
+    mVPMO_cache = 100;
+    return(true);
+    }
+  if(percent < MIN_MAX_PC_OPEN) { return(false); }
+  OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_MAX_VALVE_PC_OPEN, percent);
+  mVPMO_cache = percent;
+  return(true);
+  }
+
 // True if the controlled physical valve is thought to be at least partially open right now.
 // If multiple valves are controlled then is this true only if all are at least partially open.
 // Used to help avoid running boiler pump against closed valves.
@@ -443,6 +525,12 @@ void ModelledRadValve::recalibrate()
 // TODO: unit tests confirming that it is possible to reach all setback levels other than at highest comfort settings.
 uint8_t ModelledRadValve::computeTargetTemp()
   {
+#if defined(ENABLE_DHW_PASTEURISATION)
+  // A pasteurisation boost overrides setbacks;
+  // it only runs in FROST mode if explicitly requested (see DHWPasteuriser::tickMinute()).
+  if(Pasteuriser.isBoosting()) { return(DHWPasteuriser::BOOST_TARGET_C); }
+#endif
+
   // In FROST mode.
   if(!inWarmMode())
     {
@@ -514,8 +602,19 @@ uint8_t ModelledRadValve::computeTargetTemp()
     // Be more ready to decide room not likely occupied soon if eco-biased.
     // Note that this value is likely to be used +/- 1 so must be in range [1,23].
     const uint8_t thisHourNLOThreshold = ecoBias ? 15 : 12;
+#if defined(ENABLE_HOUR_OF_WEEK_STATS)
+    // Prefer the ranking within the same day of the week, eg so an office is not pre-warmed on Saturday,
+    // folding back to the 24h stats until that day has enough data.
+    const uint8_t howLessThanThis = HourOfWeek.countHoursLessOccupied(0);
+    const uint8_t howLessThanNext = HourOfWeek.countHoursLessOccupied(1);
+    const uint8_t hoursLessOccupiedThanThis = (0xff != howLessThanThis) ? howLessThanThis :
+        OTV0P2BASE::countStatSamplesBelow(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::STATS_SPECIAL_HOUR_CURRENT_HOUR));
+    const uint8_t hoursLessOccupiedThanNext = (0xff != howLessThanNext) ? howLessThanNext :
+        OTV0P2BASE::countStatSamplesBelow(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::STATS_SPECIAL_HOUR_NEXT_HOUR));
+#else
     const uint8_t hoursLessOccupiedThanThis = OTV0P2BASE::countStatSamplesBelow(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::STATS_SPECIAL_HOUR_CURRENT_HOUR));
     const uint8_t hoursLessOccupiedThanNext = OTV0P2BASE::countStatSamplesBelow(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR_SMOOTHED, OTV0P2BASE::STATS_SPECIAL_HOUR_NEXT_HOUR));
+#endif // defined(ENABLE_HOUR_OF_WEEK_STATS)
     const bool notLikelyOccupiedSoon = longLongVacant ||
         (likelyVacantNow &&
         // No more than about half the hours to be less occupied than this hour to be considered unlikely to be occupied.
@@ -559,6 +658,12 @@ uint8_t ModelledRadValve::computeTargetTemp()
       // Target must never be set low enough to create a frost/freeze hazard.
       const uint8_t newTarget = OTV0P2BASE::fnmax((uint8_t)(wt - setback), getFROSTTargetC());
 
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+      // Do not let a setback push cold surfaces into mould risk, though never lift the target above WARM.
+      const uint8_t mouldFloorC = MouldRisk.getFloorC();
+      if(mouldFloorC > newTarget) { return(OTV0P2BASE::fnmin(mouldFloorC, wt)); }
+#endif // defined(HUMIDITY_SENSOR_SUPPORT)
+
       return(newTarget);
       }
     // Else use WARM target as-is.
@@ -612,7 +717,18 @@ void ModelledRadValve::computeTargetTemperature()
       Occupancy.longVacant() || (hasEcoBias() && (Occupancy.getVacancyH() >= minVacancyHoursForWideningECO)));
   // Capture adjusted reference/room temperatures
   // and set callingForHeat flag also using same outline logic as computeRequiredTRVPercentOpen() will use.
-  inputState.setReferenceTemperatures(TemperatureC16.get());
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+  // Use the filtered temperature once available to reduce hunting on sensor jitter.
+  const int16_t roomC16 = TempTrend.isInitialised() ? TempTrend.getC16() : TemperatureC16.get();
+#else
+  const int16_t roomC16 = TemperatureC16.get();
+#endif
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+  // Control to the room temperature, not the hub's own dissipation.
+  inputState.setReferenceTemperatures(SelfHeating.compensate(roomC16));
+#else
+  inputState.setReferenceTemperatures(roomC16);
+#endif
   // True if the target temperature has not been met.
   const bool targetNotReached = (newTarget >= (inputState.refTempC16 >> 4));
   underTarget = targetNotReached;
@@ -649,6 +765,648 @@ void ModelledRadValve::computeCallForHeat()
 #endif
 
 
+#if defined(ENABLE_DHW_PASTEURISATION)
+// Singleton implementation for entire node.
+DHWPasteuriser Pasteuriser;
+
+// Record a completed cycle.
+void DHWPasteuriser::completed()
+  {
+  boosting = false;
+  forced = false;
+  OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_H, 0);
+  const uint8_t done = getCyclesDone();
+  if(done < 255) { OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_DONE_INV, ~(done+1)); }
+  }
+
+// Record a missed cycle.
+void DHWPasteuriser::missed()
+  {
+  const uint8_t m = getDeadlinesMissed();
+  if(m < 255) { OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_MISSED_INV, ~(m+1)); }
+  }
+
+// Call once per minute with the fresh tank temperature and mode, before recomputing the target.
+void DHWPasteuriser::tickMinute(const int16_t tempC16, const bool warm)
+  {
+  if(tempC16 >= (int16_t)(PASTEURISATION_C << 4))
+    {
+    // Complete the cycle exactly once per continuous dwell.
+    if(dwellM < 255) { if(DWELL_M == ++dwellM) { completed(); } }
+    }
+  else { dwellM = 0; }
+
+  if(boosting)
+    {
+    // An automatic boost yields to FROST mode, to start again when next due in WARM.
+    if(!forced && !warm) { boosting = false; return; }
+    // Give up on a boost that cannot reach or hold temperature.
+    if(++boostM >= MAX_BOOST_M)
+      {
+      boosting = false;
+      forced = false;
+      retryH = RETRY_H;
+      missed();
+      }
+    return;
+    }
+  if(!warm || (0 != retryH)) { return; }
+  // Start boost if overdue or unknown, or if in the window before the deadline and at the preferred hour.
+  const uint8_t h = getHoursSinceLast();
+  if((h >= MAX_INTERVAL_H) ||
+     ((h >= MAX_INTERVAL_H - WINDOW_H) &&
+      ((NO_PREFERRED_HOUR == preferredHour) || (OTV0P2BASE::getHoursLT() == preferredHour))))
+    { boosting = true; boostM = 0; }
+  }
+
+// Call once at the end of each hour, after stats have been updated.
+void DHWPasteuriser::tickHour()
+  {
+  if(0 != retryH) { --retryH; }
+  const uint8_t h = getHoursSinceLast();
+  if(h < 254)
+    {
+    OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_H, h+1);
+    // Record a missed deadline once, as it passes.
+    if(MAX_INTERVAL_H == h+1) { missed(); }
+    }
+
+  // Prefer the hour at which the tank is typically warmest, needing least extra heat.
+  // Compressed temperatures sort in the same order as uncompressed ones.
+  uint8_t best = NO_PREFERRED_HOUR;
+  uint8_t bestT = 0;
+  for(uint8_t hh = 0; hh < 24; ++hh)
+    {
+    const uint8_t t = OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_TEMP_BY_HOUR_SMOOTHED, hh);
+    if(OTV0P2BASE::STATS_UNSET_BYTE == t) { continue; }
+    if((NO_PREFERRED_HOUR == best) || (t > bestT)) { best = hh; bestT = t; }
+    }
+  preferredHour = best;
+  }
+
+// Print one-line compliance report, eg:
+//     "=P 23 62 5 0 *"
+// ie hours since last cycle (255 if unknown), preferred hour (255 if none), cycles done, cycles missed, '*' if boosting.
+void DHWPasteuriser::report(Print *const p) const
+  {
+  p->print(F("=P "));
+  p->print(getHoursSinceLast());
+  p->print(' ');
+  p->print(preferredHour);
+  p->print(' ');
+  p->print(getCyclesDone());
+  p->print(' ');
+  p->print(getDeadlinesMissed());
+  if(boosting) { p->print(F(" *")); }
+  p->println();
+  }
+#endif // defined(ENABLE_DHW_PASTEURISATION)
+
+
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+// Singleton implementation for entire node.
+NodeHealthMonitor NodeHealth;
+
+// Call once per minute after the valve has been updated.
+void NodeHealthMonitor::tickMinute(const int16_t tempC16, const uint8_t valvePC, const bool callingForHeat)
+  {
+  // Valve with no effect: re-evaluated at the end of each long well-open run.
+  if(callingForHeat && (valvePC >= WELL_OPEN_PC))
+    {
+    if(0 == openM) { openStartC16 = tempC16; }
+    if(openM < 255) { ++openM; }
+    if(NO_EFFECT_M == openM)
+      {
+      if(tempC16 - openStartC16 < MIN_RISE_C16) { flags |= HF_VALVE_NO_EFFECT; }
+      else { flags &= ~HF_VALVE_NO_EFFECT; }
+      }
+    else if((openM > NO_EFFECT_M) && (tempC16 - openStartC16 >= MIN_RISE_C16)) { flags &= ~HF_VALVE_NO_EFFECT; }
+    }
+  else { openM = 0; }
+
+  // Flatlined or jumpy sensor.
+  if(NO_READING == lastC16) { lastC16 = tempC16; return; }
+  const int16_t delta = tempC16 - lastC16;
+  lastC16 = tempC16;
+  if(0 == delta)
+    {
+    if(flatM < FLAT_M) { if(FLAT_M == ++flatM) { flags |= HF_TEMP_FLAT; } }
+    }
+  else
+    {
+    flatM = 0;
+    flags &= ~HF_TEMP_FLAT;
+    if(((delta > JUMP_C16) || (delta < -JUMP_C16)) && (jumps < 255)) { ++jumps; }
+    }
+  }
+
+// Call once per hour with the current supply voltage (cV).
+void NodeHealthMonitor::tickHour(const uint16_t supplycV)
+  {
+  // Jumpy sensor: judged over each hour.
+  if(jumps >= JUMPS_PER_H) { flags |= HF_TEMP_JUMPY; } else { flags &= ~HF_TEMP_JUMPY; }
+  jumps = 0;
+
+  // Battery: compare daily means over successive BATT_DAYS windows.
+  if(0 == supplycV) { battH = 0; battSum = 0; battDays = 0; battStartcV = 0; flags &= ~HF_BATTERY_FAST; return; }
+  battSum += supplycV;
+  if(++battH < 24) { return; }
+  const uint16_t meancV = battSum / 24;
+  battH = 0;
+  battSum = 0;
+  if(0 == battStartcV) { battStartcV = meancV; battDays = 0; return; }
+  if(++battDays < BATT_DAYS) { return; }
+  if((meancV < battStartcV) && (battStartcV - meancV >= FAST_DROP_CV_PER_WINDOW)) { flags |= HF_BATTERY_FAST; }
+  else { flags &= ~HF_BATTERY_FAST; }
+  battStartcV = meancV;
+  battDays = 0;
+  }
+#endif // defined(ENABLE_NODE_HEALTH_MONITOR)
+
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+// Singleton implementation for entire node.
+TemperatureTrendFilter TempTrend;
+
+// Call once per minute with the latest temperature (C*16).
+void TemperatureTrendFilter::update(const int16_t tempC16)
+  {
+  const int32_t z = ((int32_t)tempC16) << 8;
+  if(!initialised) { x = z; v = 0; initialised = true; return; }
+  // Predict one minute ahead, then correct position and slope from the residual.
+  x += v;
+  const int32_t r = z - x;
+  x += r >> ALPHA_SHIFT;
+  v += r >> BETA_SHIFT;
+  }
+#endif // defined(ENABLE_TEMPERATURE_TREND_FILTER)
+
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+// Singleton implementation for entire node.
+MinOpenCalibrator MinOpenCal;
+
+// Call once per minute after the valve has been updated.
+void MinOpenCalibrator::tickMinute(const uint8_t valvePC, const int16_t slopeC16PerH)
+  {
+  // Leave a manual value alone.
+  if(ModelledRadValve::isMinValvePcReallyOpenSet()) { watchM = 0; closedM = 0; learned = 0; return; }
+  if(0 == learned) { learned = ModelledRadValve::getMinValvePcReallyOpen(); }
+  // Note that heat is available when a wide opening is warming the room.
+  if((valvePC >= WIDE_PC) && (slopeC16PerH >= RISE_C16_PER_H)) { liveH = 0; }
+
+  if(0 != watchM)
+    {
+    // Abandon if closed again or opened well beyond the watched position.
+    if((0 == valvePC) || (valvePC > watchPC + SPAN_PC)) { watchM = 0; closedM = 0; return; }
+    if(++watchM <= OBSERVE_M) { return; }
+    watchM = 0;
+    const bool rose = (slopeC16PerH - startSlope >= RISE_C16_PER_H);
+    if(rose && (watchPC <= learned) && (learned > MIN_PC)) { --learned; }
+    else if(!rose && (liveH < LIVE_H) && (watchPC >= learned) && (learned < MAX_PC)) { ++learned; }
+    return;
+    }
+
+  if(0 == valvePC) { if(closedM < 255) { ++closedM; } return; }
+  // Start watching a small opening from a cold radiator.
+  if((closedM >= CLOSED_M) && (valvePC <= learned + SPAN_PC))
+    {
+    watchM = 1;
+    watchPC = valvePC;
+    startSlope = slopeC16PerH;
+    }
+  closedM = 0;
+  }
+
+// Call once per hour.
+void MinOpenCalibrator::tickHour()
+  {
+  if(liveH < 255) { ++liveH; }
+  if(++sincePersistH < 24) { return; }
+  sincePersistH = 0;
+  if((0 != learned) && !ModelledRadValve::isMinValvePcReallyOpenSet() && (learned != ModelledRadValve::getMinValvePcReallyOpen()))
+    { ModelledRadValve::setLearnedMinValvePcReallyOpen(learned); }
+  }
+#endif // defined(ENABLE_MIN_OPEN_CALIBRATION)
+
+#if defined(ENABLE_HOUR_OF_WEEK_STATS)
+// Singleton implementation for entire node.
+HourOfWeekStats HourOfWeek;
+
+// Bits of the persisted day byte.
+static const uint8_t HOW_DOW_MASK = 7;
+static const uint8_t HOW_DOW_PM = 8;
+
+// Load the day if need be and advance it past midnight.
+void HourOfWeekStats::syncDay(const uint8_t hh)
+  {
+  const bool nowPM = (hh >= 12);
+  if(0xff == dow)
+    {
+    // First call since reset: if last seen in the afternoon and now in the morning (by the restored RTC)
+    // then midnight passed while down.
+    const uint8_t b = eeprom_read_byte((uint8_t *)V0P2_EE_START_DAY_OF_WEEK);
+    const bool valid = ((b & HOW_DOW_MASK) < DAYS) && (0 == (b & ~(HOW_DOW_MASK | HOW_DOW_PM)));
+    dow = valid ? (b & HOW_DOW_MASK) : 0;
+    if(valid && (0 != (b & HOW_DOW_PM)) && !nowPM) { dow = (dow + 1) % DAYS; cachedHOW = 0xff; }
+    pm = nowPM;
+    persistDay();
+    }
+  else
+    {
+    // Within a run only a 23->0 step between consecutive calls (at least hourly, from sample()) is midnight;
+    // any other backward step (eg the clock set back) leaves the day alone.
+    if((23 == lastHH) && (0 == hh)) { dow = (dow + 1) % DAYS; cachedHOW = 0xff; }
+    // Note each change of half day, ie normally two EEPROM writes a day.
+    if(nowPM != pm) { pm = nowPM; persistDay(); }
+    }
+  lastHH = hh;
+  }
+
+// Persist the day and half of day.
+void HourOfWeekStats::persistDay()
+  { OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_DAY_OF_WEEK, dow | (pm ? HOW_DOW_PM : 0)); }
+
+// Set the day of week [0,6]; ignored if out of range.
+void HourOfWeekStats::setDayOfWeek(const uint8_t d)
+  {
+  if(d >= DAYS) { return; }
+  syncDay(OTV0P2BASE::getHoursLT());
+  dow = d;
+  cachedHOW = 0xff;
+  persistDay();
+  }
+
+// Hours in a week, ie nibbles stored.
+static const uint8_t HOW_HOURS = 7*24;
+
+// Read the stored nibble for the given hour of the week.
+static uint8_t howRead(const uint8_t how)
+  {
+  const uint8_t b = eeprom_read_byte((uint8_t *)(V0P2_EE_START_HOUR_OF_WEEK_STATS + (how >> 1)));
+  return((how & 1) ? (b >> 4) : (b & 0xf));
+  }
+
+// Write the nibble for the given hour of the week, leaving its neighbour alone.
+static void howWrite(const uint8_t how, const uint8_t n)
+  {
+  uint8_t *const p = (uint8_t *)(V0P2_EE_START_HOUR_OF_WEEK_STATS + (how >> 1));
+  const uint8_t b = eeprom_read_byte(p);
+  OTV0P2BASE::eeprom_smart_update_byte(p, (how & 1) ? ((b & 0xf) | (n << 4)) : ((b & 0xf0) | n));
+  }
+
+// Refresh the cache for the given hour of day.
+void HourOfWeekStats::refreshCache(const uint8_t hh)
+  {
+  syncDay(hh);
+  const uint8_t how = (dow * 24) + hh;
+  if(how == cachedHOW) { return; }
+  cachedHOW = how;
+  cache[0] = howRead(how);
+  cache[1] = howRead((how + 1) % HOW_HOURS);
+  refreshRanks();
+  }
+
+// Recompute the cached rankings from EEPROM; reads at most two days of nibbles, only when the hour or data change.
+void HourOfWeekStats::refreshRanks()
+  {
+  for(uint8_t i = 0; i < 2; ++i)
+    {
+    rank[i] = 0xff;
+    const uint8_t v = cache[i];
+    if(UNSET == v) { continue; }
+    // Start of the day containing the hour of interest.
+    const uint8_t how = (cachedHOW + i) % HOW_HOURS;
+    const uint8_t dayStart = how - (how % 24);
+    uint8_t set = 0;
+    uint8_t below = 0;
+    for(uint8_t h = 0; h < 24; ++h)
+      {
+      const uint8_t o = howRead(dayStart + h);
+      if(UNSET == o) { continue; }
+      ++set;
+      if(o < v) { ++below; }
+      }
+    // Only rank against a complete day, else missing (eg unoccupied night) hours would bias the rank low.
+    if(24 == set) { rank[i] = below; }
+    }
+  }
+
+// Quantise v [0,max] to a nibble [0,14], or UNSET for no data (0xff).
+static uint8_t howQuantise(const uint8_t v, const uint8_t max)
+  {
+  if(0xff == v) { return(HourOfWeekStats::UNSET); }
+  return((uint8_t)(((uint16_t)OTV0P2BASE::fnmin(v, max) * 14U + (max/2)) / max));
+  }
+
+// Smooth a new nibble sample into an old one; the first sample is taken as is.
+// Always moves at least one step towards a different sample so that rounding cannot stall it short of the target.
+static uint8_t howSmooth(const uint8_t oldN, const uint8_t newN)
+  {
+  if(HourOfWeekStats::UNSET == newN) { return(oldN); }
+  if(HourOfWeekStats::UNSET == oldN) { return(newN); }
+  const uint8_t s = (uint8_t)((3*oldN + newN + 2) / 4);
+  if((s == oldN) && (newN != oldN)) { return((newN > oldN) ? (oldN + 1) : (oldN - 1)); }
+  return(s);
+  }
+
+// Call with each full stats sample for the current hour.
+void HourOfWeekStats::sample(const uint8_t occpc)
+  {
+  refreshCache(OTV0P2BASE::getHoursLT());
+  const uint8_t n = howSmooth(cache[0], howQuantise(occpc, 100));
+  if(n == cache[0]) { return; }
+  cache[0] = n;
+  howWrite(cachedHOW, n);
+  refreshRanks();
+  }
+
+// Smoothed occupancy nibble for this (0) or the next (1) hour of the week.
+uint8_t HourOfWeekStats::getOccupancy(const uint8_t hourOffset)
+  {
+  refreshCache(OTV0P2BASE::getHoursLT());
+  return(cache[hourOffset ? 1 : 0]);
+  }
+
+// Count of hours on the same day of week less occupied than this (0) or the next (1) hour; 0xff if too little data.
+uint8_t HourOfWeekStats::countHoursLessOccupied(const uint8_t hourOffset)
+  {
+  refreshCache(OTV0P2BASE::getHoursLT());
+  return(rank[hourOffset ? 1 : 0]);
+  }
+#endif // defined(ENABLE_HOUR_OF_WEEK_STATS)
+
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+// Singleton implementation for entire node.
+SelfHeatingCompensator SelfHeating;
+
+// Call once per minute before the valve is recomputed.
+void SelfHeatingCompensator::tickMinute(const int16_t rawC16, const bool quiet)
+  {
+  if(!loaded)
+    {
+    // Restore any gain learned before the last reset.
+    const uint8_t g = eeprom_read_byte((uint8_t *)V0P2_EE_START_SELF_HEATING_GAIN_C16);
+    if(g <= MAX_GAIN_C16) { gainC16 = g; calibrated = true; }
+    loaded = true;
+    }
+
+  // Run down any quiet window, abandoning it as soon as it stops being quiet;
+  // else start one when due and quiet.
+  if(0 != quietM) { quietM = quiet ? (quietM - 1) : 0; }
+  else if(quiet && (sinceQuietH >= CAL_INTERVAL_H)) { quietM = QUIET_M; sinceQuietH = 0; }
+
+  const uint8_t activity = (0 == cycles) ? lastActivity : (uint8_t)(sumActivity / cycles);
+  sumActivity = 0;
+  cycles = 0;
+  // First-order lag: smoothed += (new - smoothed) / 2^LAG_SHIFT.
+  smoothedActivity = (uint16_t)((int32_t)smoothedActivity + ((((int32_t)activity << 8) - (int32_t)smoothedActivity) >> LAG_SHIFT));
+
+  // Calibration: after a sharp activity step, a lag's worth of minutes later
+  // the model says ~64% ((1-1/16)^16 ~ 0.36) of gain * step should have appeared as a temperature change.
+  if(0 != calM)
+    {
+    const int16_t drift = (int16_t)activity - (int16_t)lastActivity; // lastActivity is the post-step level.
+    if(!quiet || (drift > STEP_DRIFT) || (drift < -(int16_t)STEP_DRIFT)) { calM = 0; }
+    else if(++calM > (1 << LAG_SHIFT))
+      {
+      calM = 0;
+      // est = dT * 255 / (0.64 * step) ~ dT * 398 / step.
+      const int32_t est = ((int32_t)(rawC16 - calStartC16) * 398) / calStep;
+      // Ignore implausible estimates, eg where the room itself moved;
+      // else adopt the first and blend in later ones slowly.
+      if((est >= 0) && (est <= MAX_GAIN_C16))
+        {
+        if(!calibrated) { gainC16 = (uint8_t)est; calibrated = true; }
+        else { gainC16 = (uint8_t)(gainC16 + ((int16_t)est - (int16_t)gainC16) / 4); }
+        // At most one write per step, ie normally no more than every CAL_INTERVAL_H hours.
+        OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_SELF_HEATING_GAIN_C16, gainC16);
+        }
+      }
+    }
+  else
+    {
+    const int16_t step = (int16_t)activity - (int16_t)lastActivity;
+    if(quiet && ((step >= STEP_ACTIVITY) || (step <= -(int16_t)STEP_ACTIVITY)))
+      {
+      calM = 1;
+      calStep = step;
+      calStartC16 = lastC16; // Temperature before the step had any effect.
+      }
+    // While calibrating this is held at the post-step level to measure drift against.
+    lastActivity = activity;
+    }
+  lastC16 = rawC16;
+  }
+#endif // defined(ENABLE_SELF_HEATING_COMPENSATION)
+
+#if defined(ENABLE_HYDRONIC_BALANCING)
+// Singleton implementation for entire node.
+HydronicBalancer Balancer;
+
+// Note a stats sample from a remote valve.
+void HydronicBalancer::noteStats(const uint8_t *const id, const uint8_t valvePC, const int16_t tempC16, const uint16_t nowM)
+  {
+  Entry *e = NULL;
+  for(uint8_t i = 0; i < MAX_VALVES; ++i)
+    {
+    Entry &v = valves[i];
+    if(v.used && (v.id[0] == id[0]) && (v.id[1] == id[1])) { e = &v; break; }
+    if(!v.used && (NULL == e)) { e = &v; }
+    }
+  if(NULL == e) { return; } // Table full.
+  const bool open = (valvePC >= OPEN_PC);
+  if(!e->used) { e->used = true; e->id[0] = id[0]; e->id[1] = id[1]; }
+  else if(open && e->lastOpen)
+    {
+    // Rate over the gap, allowing for midnight wrap.
+    const uint16_t gapM = (nowM + 1440 - e->lastM) % 1440;
+    if((gapM >= MIN_GAP_M) && (gapM <= MAX_GAP_M))
+      {
+      const int16_t r = OTV0P2BASE::fnmin((int16_t)(((int32_t)(tempC16 - e->lastC16) * 60) / gapM), (int16_t)127);
+      // Only rises say anything about flow; blend in slowly.
+      if(r > 0) { e->rateC16PerH = (0 == e->rateC16PerH) ? (int8_t)r : (int8_t)(e->rateC16PerH + (r - e->rateC16PerH) / 4); }
+      }
+    }
+  e->lastOpen = open;
+  e->lastC16 = tempC16;
+  e->lastM = nowM;
+  e->silentH = 0;
+  }
+
+// Age entries and free those silent too long, so that departed valves neither hold slots nor skew the median.
+void HydronicBalancer::tickHour()
+  {
+  for(uint8_t i = 0; i < MAX_VALVES; ++i)
+    {
+    Entry &v = valves[i];
+    if(!v.used) { continue; }
+    if(++v.silentH >= STALE_H) { memset(&v, 0, sizeof(v)); }
+    }
+  }
+
+// Median of the known warm-up rates, 0 if none.
+int8_t HydronicBalancer::medianRate() const
+  {
+  int8_t rates[MAX_VALVES];
+  uint8_t n = 0;
+  for(uint8_t i = 0; i < MAX_VALVES; ++i)
+    {
+    const int8_t r = valves[i].rateC16PerH;
+    if(r <= 0) { continue; }
+    // Insertion sort.
+    uint8_t j = n++;
+    for( ; (j > 0) && (rates[j-1] > r); --j) { rates[j] = rates[j-1]; }
+    rates[j] = r;
+    }
+  return((0 == n) ? 0 : rates[n/2]);
+  }
+
+// Recommended maximum-open limit for the given slot.
+uint8_t HydronicBalancer::getLimitPC(const uint8_t slot) const
+  {
+  if(slot >= MAX_VALVES) { return(100); }
+  const int8_t r = valves[slot].rateC16PerH;
+  const int8_t m = medianRate();
+  if((r <= 0) || (r <= m)) { return(100); }
+  return(OTV0P2BASE::fnmax((uint8_t)((100 * (int16_t)m) / r), MIN_LIMIT_PC));
+  }
+
+// Print one line per valve with a known rate.
+void HydronicBalancer::report(Print *const p) const
+  {
+  for(uint8_t i = 0; i < MAX_VALVES; ++i)
+    {
+    const Entry &v = valves[i];
+    if(!v.used || (v.rateC16PerH <= 0)) { continue; }
+    p->print(F("=BAL "));
+    if(v.id[0] < 16) { p->print('0'); }
+    p->print(v.id[0], HEX);
+    if(v.id[1] < 16) { p->print('0'); }
+    p->print(v.id[1], HEX);
+    p->print(' ');
+    p->print(v.rateC16PerH);
+    p->print(' ');
+    p->println(getLimitPC(i));
+    }
+  }
+#endif // defined(ENABLE_HYDRONIC_BALANCING)
+
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+// Singleton implementation for entire node.
+BoilerDemandModulator BoilerDemand;
+
+// Call once per minute with the boiler on/off state.
+uint8_t BoilerDemandModulator::tickMinute(const bool boilerOn)
+  {
+  if(0 != count) { meanPC = (uint8_t)(sumPC / count); }
+  sumPC = 0;
+  count = 0;
+  uint8_t peak = 0;
+  for(uint8_t i = 0; i < WINDOW_M; ++i) { if(maxPC[i] > peak) { peak = maxPC[i]; } }
+  for(uint8_t i = WINDOW_M; --i > 0; ) { maxPC[i] = maxPC[i-1]; }
+  maxPC[0] = 0;
+  if(!boilerOn) { level = 0; return(level); }
+  // Weight towards the most-open valve, softened by the mean.
+  const uint8_t target = OTV0P2BASE::fnmax((uint8_t)((3U * peak + OTV0P2BASE::fnmin(meanPC, peak)) / 4), MIN_ON_PC);
+  if(0 == level) { level = MIN_ON_PC; } // Start gently.
+  if(target > level) { level = OTV0P2BASE::fnmin(target, (uint8_t)(level + SLEW_PC)); }
+  else if(target < level) { level = OTV0P2BASE::fnmax(target, (uint8_t)(level - SLEW_PC)); }
+  return(level);
+  }
+#endif // defined(ENABLE_BOILER_DEMAND_MODULATION)
+
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+// Singleton implementation for entire node.
+BuildingKeyRotation KeyRotation;
+
+// Write the alternate key, its role and hours left.
+// The hours byte marks the alternate key valid, so it is invalidated first and written last:
+// a reset part way through then leaves no alternate key rather than a half-written one.
+static void writeAltKey(const uint8_t *const key, const bool previous, const uint8_t hours)
+  {
+  OTV0P2BASE::eeprom_smart_erase_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H);
+  for(uint8_t i = 0; i < V0P2_EE_LEN_ALT_KEY; ++i)
+    { OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_ALT_KEY + i, key[i]); }
+  OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_ALT_KEY_ROLE, previous ? 1 : 0);
+  OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H, hours);
+  }
+
+// Load the next key to replace the primary in hours [1,254].
+bool BuildingKeyRotation::setNextKey(const uint8_t *const key, const uint8_t hours)
+  {
+  if((0 == hours) || (hours > 254)) { return(false); }
+  writeAltKey(key, false, hours);
+  return(true);
+  }
+
+// Forget any alternate key, erasing it.
+void BuildingKeyRotation::clear()
+  {
+  OTV0P2BASE::eeprom_smart_erase_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H);
+  for(uint8_t i = 0; i < V0P2_EE_LEN_ALT_KEY; ++i)
+    { OTV0P2BASE::eeprom_smart_erase_byte((uint8_t *)V0P2_EE_START_ALT_KEY + i); }
+  altHint = 0;
+  }
+
+// Call once at the end of each hour.
+void BuildingKeyRotation::tickHour()
+  {
+  const uint8_t h = eeprom_read_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H);
+  if(0xff == h) { return; }
+  if(h > 1) { OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H, h-1); return; }
+  // Due now.
+  if(0 != eeprom_read_byte((uint8_t *)V0P2_EE_START_ALT_KEY_ROLE)) { clear(); return; }
+  // Promote the next key, keeping the old primary as the previous key for the grace period.
+  // TX message counters are deliberately not reset so that hubs' replay protection is undisturbed.
+  uint8_t oldKey[16];
+  uint8_t newKey[16];
+  if(!getAltKey(newKey)) { return; }
+  if(!OTV0P2BASE::getPrimaryBuilding16ByteSecretKey(oldKey))
+    {
+    // No primary key to keep: just install the new one.
+    if(OTV0P2BASE::setPrimaryBuilding16ByteSecretKey(newKey)) { clear(); }
+    return;
+    }
+  // Install the new primary while the (intact) next key is still marked due,
+  // so that a reset part way through simply promotes it again next hour.
+  if(!OTV0P2BASE::setPrimaryBuilding16ByteSecretKey(newKey)) { return; } // Try again next hour.
+  // Only then overwrite the alternate slot with the old key (see writeAltKey() for ordering).
+  writeAltKey(oldKey, true, GRACE_H);
+  // Senders that were on the new (alternate) key are now on the primary, and vice versa.
+  altHint = ~altHint;
+  }
+
+// Copy the alternate key to key (16 bytes) and return true, else false if there is none.
+bool BuildingKeyRotation::getAltKey(uint8_t *const key) const
+  {
+  if(0xff == eeprom_read_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H)) { return(false); }
+  eeprom_read_block(key, (uint8_t *)V0P2_EE_START_ALT_KEY, V0P2_EE_LEN_ALT_KEY);
+  return(true);
+  }
+
+// Record which key worked for a sender with the given first ID byte.
+void BuildingKeyRotation::noteKeyUsed(const uint8_t idByte0, const bool alt)
+  {
+  const uint16_t bit = 1U << hintBit(idByte0);
+  if(alt) { altHint |= bit; } else { altHint &= ~bit; }
+  }
+
+// Print one line: "=KR" alone if no alternate key, else "=KR N|P hours".
+void BuildingKeyRotation::report(Print *const p) const
+  {
+  p->print(F("=KR"));
+  const uint8_t h = eeprom_read_byte((uint8_t *)V0P2_EE_START_ALT_KEY_H);
+  if(0xff != h)
+    {
+    p->print(' ');
+    p->print((0 != eeprom_read_byte((uint8_t *)V0P2_EE_START_ALT_KEY_ROLE)) ? 'P' : 'N');
+    p->print(' ');
+    p->print(h);
+    }
+  p->println();
+  }
+#endif // defined(ENABLE_BUILDING_KEY_ROTATION)
+
+
 // The STATS_SMOOTH_SHIFT is chosen to retain some reasonable precision within a byte and smooth over a weekly cycle.
 #define STATS_SMOOTH_SHIFT 3 // Number of bits of shift for smoothed value: larger => larger time-constant; strictly positive.
 
@@ -814,6 +1572,11 @@ void sampleStats(const bool fullSample)
   simpleUpdateStatsPair(V0P2BASE_EE_STATS_SET_OCCPC_BY_HOUR, hh, smartDivToU8(occpcTotal, sc));
 #endif 
 
+#if defined(ENABLE_HOUR_OF_WEEK_STATS)
+  // Occupancy by hour of the week.
+  HourOfWeek.sample(smartDivToU8(occpcTotal, sc));
+#endif
+
 #if defined(HUMIDITY_SENSOR_SUPPORT)
   // Relative humidity percent, if supported; last and smoothed data sets,
   simpleUpdateStatsPair(V0P2BASE_EE_STATS_SET_RHPC_BY_HOUR, hh, smartDivToU8(rhpcTotal, sc));
@@ -881,6 +1644,90 @@ void populateCoreStats(OTV0P2BASE::FullStatsMessageCore_t *const content)
 #endif // ENABLE_FS20_ENCODING_SUPPORT
 
 
+#if defined(ENABLE_CPU_CLOCK_BURST)
+// CLKPR prescaler bits for a burst: clock source / 2, ie 4MHz from the 8MHz internal RC.
+static const uint8_t CPU_CLOCK_BURST_CLKPS = 1;
+// Timer0 clock-select bits: /64 as normally used for millis(), and /256 to keep the same rate at 4x the clock.
+static const uint8_t TIMER0_CS_MASK = _BV(CS02) | _BV(CS01) | _BV(CS00);
+static const uint8_t TIMER0_CS_64 = _BV(CS01) | _BV(CS00);
+static const uint8_t TIMER0_CS_256 = _BV(CS02);
+CPUClockBurst::CPUClockBurst(const bool enable) : savedCLKPS(0xff), savedTCCR0B(0), savedPCICR(0)
+  {
+  if(!enable) { return; }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+    // Nested or already fast: leave alone.
+    if(CPU_CLOCK_BURST_CLKPS == (CLKPR & 0xf)) { return; }
+    // Timer0 stopped (eg powered down) or at /64 can be kept right; else do not boost.
+    const uint8_t cs0 = TCCR0B & TIMER0_CS_MASK;
+    if((0 != cs0) && (TIMER0_CS_64 != cs0)) { return; }
+    savedTCCR0B = TCCR0B;
+    if(0 != cs0) { TCCR0B = (savedTCCR0B & ~TIMER0_CS_MASK) | TIMER0_CS_256; }
+    // Defer pin-change ISRs; their flags stay latched in PCIFR until re-enabled.
+    savedPCICR = PCICR;
+    PCICR = 0;
+    savedCLKPS = CLKPR & 0xf;
+    // Timed sequence: new value must be written within 4 cycles of setting CLKPCE.
+    CLKPR = _BV(CLKPCE);
+    CLKPR = CPU_CLOCK_BURST_CLKPS;
+    }
+  }
+CPUClockBurst::~CPUClockBurst()
+  {
+  if(0xff == savedCLKPS) { return; }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+    CLKPR = _BV(CLKPCE);
+    CLKPR = savedCLKPS;
+    TCCR0B = savedTCCR0B;
+    // Any pin changes latched during the burst are serviced as soon as interrupts are re-enabled.
+    PCICR = savedPCICR;
+    }
+  }
+#endif // defined(ENABLE_CPU_CLOCK_BURST)
+
+bool SerialSession::coalescing;
+bool SerialSession::woken;
+
+// Drain (if any session woke the UART this cycle) and power down the UART, ending coalescing.
+void SerialSession::endCycle()
+  {
+  if(woken) { OTV0P2BASE::flushSerialProductive(); }
+  OTV0P2BASE::powerDownSerial();
+  coalescing = false;
+  woken = false;
+  }
+
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+// Timer2 compare match only needs to wake the CPU.
+EMPTY_INTERRUPT(TIMER2_COMPA_vect);
+
+// Sleep in power-save mode until the sub-cycle time reaches sct or any interrupt arrives.
+bool sleepUntilSubCycleTimeOrInt(const uint8_t sct)
+  {
+  if(OTV0P2BASE::getSubCycleTime() >= sct) { return(false); }
+  // Async timer register writes must complete before sleeping.
+  OCR2A = sct;
+  while(0 != (ASSR & _BV(OCR2AUB))) { }
+  TIFR2 = _BV(OCF2A); // Discard any stale match.
+  TIMSK2 |= _BV(OCIE2A);
+  set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+  cli();
+  // Re-check with interrupts off so that a match just now cannot be missed and leave this asleep for the whole cycle.
+  if(OTV0P2BASE::getSubCycleTime() < sct)
+    {
+    sleep_enable();
+    sei(); // The instruction after sei() always runs before any pending interrupt, so this cannot miss the wakeup.
+    sleep_cpu();
+    sleep_disable();
+    }
+  sei();
+  TIMSK2 &= ~_BV(OCIE2A);
+  return(true);
+  }
+#endif // defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+
+
 // Call this to do an I/O poll if needed; returns true if something useful definitely happened.
 // This call should typically take << 1ms at 1MHz CPU.
 // Does not change CPU clock speeds, mess with interrupts (other than possible brief blocking), or sleep.
@@ -913,8 +1760,48 @@ bool pollIO(const bool force)
 
 #ifdef ENABLE_STATS_TX
 #if defined(ENABLE_JSON_OUTPUT)
+// Worst-case number of distinct stats that bareStatsTX() may put() into ss1 in this build;
+// must be kept in step with the put() calls there, else put() silently fails once full
+// and the low-priority items (eg "vC", "tS") are never sent.
+// Sized per build so as to cost no RAM for stats that can never be present.
+static const uint8_t ss1Capacity = 1 // "T|C16"
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+    + 1 // "H|%"
+#if defined(ENABLE_MOULD_RISK_STATS)
+    + 1 // "mR"
+#endif
+#endif
+#if defined(ENABLE_OCCUPANCY_SUPPORT)
+    + 1 // "O"
+#if !defined(ENABLE_TRIMMED_BANDWIDTH)
+    + 1 // "vac|h"
+#endif
+#endif
+    + 1 // "B|cV" (when not mains powered)
+#ifdef ENABLE_BOILER_HUB
+    + 1 // "b"
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+    + 1 // "bD|%"
+#endif
+#endif
+#ifdef ENABLE_AMBLIGHT_SENSOR
+    + 1 // "L"
+#endif
+#ifdef ENABLE_VOICE_STATS
+    + 1 // voice
+#endif
+#if defined(ENABLE_LOCAL_TRV)
+    + 3 // "v|%", "tT|C", "tS|C"
+#if !defined(ENABLE_TRIMMED_BANDWIDTH)
+    + 1 // "vC|%"
+#endif
+#endif
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+    + 1 // "hF"
+#endif
+    ;
 // Managed JSON stats.
-static OTV0P2BASE::SimpleStatsRotation<10> ss1; // Configured for maximum different stats.	// FIXME increased for voice
+static OTV0P2BASE::SimpleStatsRotation<ss1Capacity> ss1; // Configured for maximum different stats.
 #endif // ENABLE_STATS_TX
 // Do bare stats transmission.
 // Output should be filtered for items appropriate
@@ -927,6 +1814,14 @@ static OTV0P2BASE::SimpleStatsRotation<10> ss1; // Configured for maximum differ
 // as assumed supplied by security layer to remote recipent.
 void bareStatsTX(const bool allowDoubleTX, const bool doBinary)
   {
+#if defined(ENABLE_URGENT_STATS_TX)
+  // Note what is about to be reported so that only further big changes count as urgent,
+  // and that anything already pending is covered by this TX.
+  urgentStatsTXPending = false;
+  urgentStatsTXLastValvePC = NominalRadValve.get();
+  urgentStatsTXLastTargetC = NominalRadValve.getTargetTempC();
+#endif // defined(ENABLE_URGENT_STATS_TX)
+
   // Note if radio/comms channel is itself framed.
   const bool framed = !PrimaryRadio.getChannelConfig()->isUnframed;
 #if defined(ENABLE_RFM23B_FS20_RAW_PREAMBLE)
@@ -942,7 +1837,7 @@ void bareStatsTX(const bool allowDoubleTX, const bool doBinary)
   const bool doEnc = false;
 #endif
 
-  const bool neededWaking = OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>(); // FIXME
+  SerialSession session;
 #if (FullStatsMessageCore_MAX_BYTES_ON_WIRE > STATS_MSG_MAX_LEN)
 #error FullStatsMessageCore_MAX_BYTES_ON_WIRE too big
 #endif // FullStatsMessageCore_MAX_BYTES_ON_WIRE > STATS_MSG_MAX_LEN
@@ -1053,6 +1948,9 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
     ss1.put(TemperatureC16);
 #if defined(HUMIDITY_SENSOR_SUPPORT)
     ss1.put(RelHumidity);
+#if defined(ENABLE_MOULD_RISK_STATS)
+    ss1.put(MouldRisk.tag(), MouldRisk.get());
+#endif // defined(ENABLE_MOULD_RISK_STATS)
 #endif // defined(HUMIDITY_SENSOR_SUPPORT)
 #if defined(ENABLE_OCCUPANCY_SUPPORT)
     ss1.put(Occupancy.twoBitTag(), Occupancy.twoBitOccupancyValue()); // Reduce spurious TX cf percentage.
@@ -1066,6 +1964,9 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
 #ifdef ENABLE_BOILER_HUB
     // Show boiler state for boiler hubs.
     ss1.put("b", (int) isBoilerOn());
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+    ss1.put(BoilerDemand.tag(), BoilerDemand.get(), true); // Low priority; "b" carries the essential on/off.
+#endif
 #endif // ENABLE_BOILER_HUB
 #ifdef ENABLE_AMBLIGHT_SENSOR
     ss1.put(AmbLight); // Always send ambient light level (assuming sensor is present).
@@ -1082,6 +1983,9 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Bin gen err!");
     ss1.put(NominalRadValve.tagCMPC(), NominalRadValve.getCumulativeMovementPC(), true); // Low priority as notionally redundant.
 #endif // !defined(ENABLE_TRIMMED_BANDWIDTH)
 #endif // defined(ENABLE_LOCAL_TRV)
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+    ss1.put(NodeHealth.tag(), NodeHealth.get(), true); // Low priority; changes rarely.
+#endif // defined(ENABLE_NODE_HEALTH_MONITOR)
 
 #if defined(ENABLE_ALWAYS_TX_ALL_STATS)
     const uint8_t privacyLevel = OTV0P2BASE::stTXalwaysAll;
@@ -1181,6 +2085,11 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
       // Distinguished 'invalid' valve position; never mistaken for a real valve.
       const uint8_t valvePC = 0x7f;
 #endif // defined(ENABLE_NOMINAL_RAD_VALVE)
+#if defined(ENABLE_CPU_CLOCK_BURST)
+      OTV0P2BASE::flushSerialSCTSensitive(); // Serial must be idle while the clock is boosted.
+      // Until the end of this scope: no serial, _delay_*() or cycle-count timing; pin-change ISRs (radio RX) deferred.
+      CPUClockBurst fast(!Supply_cV.isSupplyVoltageLow());
+#endif
       const uint8_t bodylen = OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::getInstance().generateSecureOFrameRawForTX(
             realTXFrameStart - offset, sizeof(buf) - (realTXFrameStart-buf) + offset,
             txIDLen, valvePC, (const char *)bufJSON, e, NULL, key);
@@ -1247,7 +2156,6 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("JSON gen err!");
 #endif // defined(ENABLE_JSON_OUTPUT)
 
 //DEBUG_SERIAL_PRINTLN_FLASHSTRING("Stats TX");
-  if(neededWaking) { OTV0P2BASE::flushSerialProductive(); OTV0P2BASE::powerDownSerial(); }
   }
 #endif // defined(ENABLE_STATS_TX)
 
@@ -1322,6 +2230,39 @@ static void endOfHourTasks()
       const uint8_t updated = ~((~sloInv)-1);
       OTV0P2BASE::eeprom_smart_update_byte((uint8_t *)OTV0P2BASE::V0P2BASE_EE_START_SETBACK_LOCKOUT_COUNTDOWN_H_INV, updated);
       }
+#endif
+#if defined(HAS_DORM1_VALVE_DRIVE) && defined(ENABLE_LOCAL_TRV)
+    // Recalibrate the direct-drive valve only once the estimated dead-reckoning error has grown too large,
+    // and not while the user may be adjusting it.
+    if(ValveDirectDR.isRecalibrationDue() && ValveDirect.isInNormalRunState() && !recentUIControlUse())
+      {
+      ValveDirect.recalibrate();
+      ValveDirectDR.recalibrated();
+      }
+#endif
+#if defined(ENABLE_DHW_PASTEURISATION)
+    // Advance pasteurisation compliance clock and relearn preferred boost hour.
+    Pasteuriser.tickHour();
+#endif
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+    // Promote a pending next building key, or forget the previous one, when due.
+    KeyRotation.tickHour();
+#endif
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+    // Persist any learned change to the minimum really-open %, daily.
+    MinOpenCal.tickHour();
+#endif
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+    // Judge hourly/daily fault indicators.
+    NodeHealth.tickHour(Supply_cV.isMains() ? 0 : Supply_cV.get());
+#endif
+#if defined(ENABLE_HYDRONIC_BALANCING)
+    // Forget valves not heard from in a while.
+    Balancer.tickHour();
+#endif
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+    // Schedule self-heating calibration windows.
+    SelfHeating.tickHour();
 #endif
   }
 
@@ -1598,6 +2539,10 @@ static volatile uint16_t receivedCallForHeatID;
 // Does not have to be thread-/ISR- safe.
 void remoteCallForHeatRX(const uint16_t id, const uint8_t percentOpen)
   {
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+  // All valve positions count towards the demand level, not just those calling for heat.
+  BoilerDemand.noteValve(percentOpen);
+#endif
   // TODO: Should be filtering first by housecode
   // then by individual and tracked aggregate valve-open percentage.
   // Only individual valve levels used here; no state is retained.
@@ -1673,10 +2618,14 @@ static bool setUpContinuousRX()
   // to avoid temperature over-estimates from self-heating,
   // and could be disabled if no local valve is being run to provide better response to remote nodes.
 #ifdef ENABLE_DEFAULT_ALWAYS_RX
-  const bool needsToListen = true; // By default listen if always doing RX.
+  bool needsToListen = true; // By default listen if always doing RX.
 #else
   bool needsToListen = inHubMode(); // By default assume no need to listen unless in hub mode.
 #endif
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+  // Briefly stop listening when asked so that the self-heating step can be measured.
+  if(SelfHeating.isQuietWindow()) { needsToListen = false; }
+#endif
 
 #if 0 && defined(DEBUG) && defined(ENABLE_DEFAULT_ALWAYS_RX)
   const int8_t listenChannel = PrimaryRadio.getListenChannel();
@@ -1830,13 +2779,89 @@ static void processCallsForHeat(const bool second0)
     // Set BOILER_OUT as appropriate for calls for heat.
     // Local calls for heat come via the same route (TODO-607).
     fastDigitalWrite(OUT_HEATCALL, (isBoilerOn() ? HIGH : LOW));
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+    // Update the modulated demand level once per minute, following the on/off decision above.
+    if(second0)
+      {
+      const uint8_t old = BoilerDemand.get();
+      const uint8_t level = BoilerDemand.tickMinute(isBoilerOn());
+#if defined(OUT_BOILER_DEMAND_PWM)
+      analogWrite(OUT_BOILER_DEMAND_PWM, (uint8_t)((255U * level) / 100));
+#endif
+      if(level != old) { OTV0P2BASE::serialPrintAndFlush(F("=BD ")); OTV0P2BASE::serialPrintAndFlush((int) level); OTV0P2BASE::serialPrintlnAndFlush(); }
+      }
+#endif // defined(ENABLE_BOILER_DEMAND_MODULATION)
     }
   // Force boiler off when not in hub mode.
-  else { fastDigitalWrite(OUT_HEATCALL, LOW); }
+  else
+    {
+    fastDigitalWrite(OUT_HEATCALL, LOW);
+#if defined(ENABLE_BOILER_DEMAND_MODULATION) && defined(OUT_BOILER_DEMAND_PWM)
+    analogWrite(OUT_BOILER_DEMAND_PWM, 0);
+#endif
+    }
 #endif // defined(ENABLE_BOILER_HUB)
   }
 
 
+#if defined(ENABLE_INPUT_SNAPSHOT_LOG)
+// Input snapshot logging (not record/replay).
+// Log a once-per-minute snapshot of the sensor inputs and mode to serial as one compact line, eg:
+//     "~I 1234 3 322 51 120 9 250"
+// for (in order) local minutes since midnight, W/B mode bits, temperature C16, RH%, light, pot, supply cV.
+// Unavailable inputs are logged as 0; PRNG reseeds are logged separately as "~R a b c".
+// Button/pot events within the minute, occupancy marks, CLI commands and RX frames are not logged,
+// so this cannot drive a deterministic replay.
+static void logInputSnapshot()
+  {
+  SerialSession session;
+  Serial.print(F("~I "));
+  Serial.print(OTV0P2BASE::getMinutesSinceMidnightLT());
+  Serial.print(' ');
+  Serial.print((inWarmMode() ? 1 : 0) | (inBakeMode() ? 2 : 0));
+  Serial.print(' ');
+  Serial.print(TemperatureC16.get());
+  Serial.print(' ');
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+  Serial.print(RelHumidity.get());
+#else
+  Serial.print('0');
+#endif
+  Serial.print(' ');
+#if defined(ENABLE_AMBLIGHT_SENSOR)
+  Serial.print(AmbLight.get());
+#else
+  Serial.print('0');
+#endif
+  Serial.print(' ');
+#if defined(TEMP_POT_AVAILABLE)
+  Serial.print(TempPot.get());
+#else
+  Serial.print('0');
+#endif
+  Serial.print(' ');
+  Serial.println(Supply_cV.get());
+  OTV0P2BASE::flushSerialSCTSensitive();
+  }
+
+// Reseed the PRNG as seedRNG8() does, logging the seed bytes.
+static void loggedSeedRNG8(const uint8_t s1, const uint8_t s2, const uint8_t s3)
+  {
+  OTV0P2BASE::seedRNG8(s1, s2, s3);
+  SerialSession session;
+  Serial.print(F("~R "));
+  Serial.print(s1);
+  Serial.print(' ');
+  Serial.print(s2);
+  Serial.print(' ');
+  Serial.println(s3);
+  OTV0P2BASE::flushSerialSCTSensitive();
+  }
+#define seedRNG8Logged(s1, s2, s3) loggedSeedRNG8((s1), (s2), (s3))
+#else
+#define seedRNG8Logged(s1, s2, s3) OTV0P2BASE::seedRNG8((s1), (s2), (s3))
+#endif // defined(ENABLE_INPUT_SNAPSHOT_LOG)
+
 // Main loop for OpenTRV radiator control.
 // Note: exiting and re-entering can take a little while, handling Arduino background tasks such as serial.
 void loopOpenTRV()
@@ -1908,8 +2933,12 @@ void loopOpenTRV()
 #endif
 //  // Ensure that serial I/O is off while sleeping, unless listening with radio.
 //  if(!needsToListen) { powerDownSerial(); } else { powerUpSerialIfDisabled<V0P2_UART_BAUD>(); }
-  // Ensure that serial I/O is off while sleeping.
-  OTV0P2BASE::powerDownSerial();
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+  // Note how busy the last cycle was: fully while listening, else the fraction awake (including any LED flashes).
+  SelfHeating.tickCycle(needsToListen ? 255 : OTV0P2BASE::getSubCycleTime());
+#endif
+  // Ensure that serial I/O is drained and off while sleeping.
+  SerialSession::endCycle();
   // Power down most stuff (except radio for hub RX).
   OTV0P2BASE::minimisePowerWithoutSleep();
   uint_fast8_t newTLSD;
@@ -1937,7 +2966,11 @@ void loopOpenTRV()
       // then this can only sleep for a short time between explicit poll()s,
       // though in any case allow wake on interrupt to minimise loop timing jitter
       // when the slow RTC 'end of sleep' tick arrives.
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+      RXPoll.napAndAdapt(&PrimaryRadio);
+#else
       OTV0P2BASE::nap(WDTO_15MS, true);
+#endif
       }
     else
       {
@@ -1948,6 +2981,10 @@ void loopOpenTRV()
 //    DEBUG_SERIAL_PRINTLN_FLASHSTRING("w"); // Wakeup.
     }
   TIME_LSD = newTLSD;
+  SerialSession::beginCycle();
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+  Relay.tickCycle();
+#endif
 #if defined(ENABLE_WATCHDOG_SLOW)
   // Reset and immediately re-prime the RTC-based watchdog.
   OTV0P2BASE::resetRTCWatchDog();
@@ -2088,7 +3125,7 @@ void loopOpenTRV()
       }
 
     // Churn/reseed PRNG(s) a little to improve unpredictability in use: should be lightweight.
-    case 2: { if(runAll) { OTV0P2BASE::seedRNG8(minuteCount ^ OTV0P2BASE::getCPUCycleCount() ^ (uint8_t)Supply_cV.get(), OTV0P2BASE::_getSubCycleTime() ^ AmbLight.get(), (uint8_t)TemperatureC16.get()); } break; }
+    case 2: { if(runAll) { seedRNG8Logged(minuteCount ^ OTV0P2BASE::getCPUCycleCount() ^ (uint8_t)Supply_cV.get(), OTV0P2BASE::_getSubCycleTime() ^ AmbLight.get(), (uint8_t)TemperatureC16.get()); } break; }
     // Force read of supply/battery voltage; measure and recompute status (etc) less often when already thought to be low, eg when conserving.
     case 4: { if(runAll) { Supply_cV.read(); } break; }
 
@@ -2114,7 +3151,7 @@ void loopOpenTRV()
       // but occasionally send otherwise to make (secure) traffic analysis harder,
       // though not enough to make a significant difference to bandwidth.
       // Send very slightly more often when changed stats pending to send upstream.
-      // TODO: send immediately with 100% valve payload when user puts system into BAKE mode for fast response.
+      // BAKE, significant UI changes and large valve moves are also sent within the cycle they occur in (ENABLE_URGENT_STATS_TX).
       if(!minute1From4AfterSensors && (OTV0P2BASE::randRNG8() > (ss1.changedValue() ? 4 : 3))) { break; }
 #endif
 
@@ -2130,8 +3167,15 @@ void loopOpenTRV()
         {
         // Handle any pending I/O while waiting.
         if(handleQueuedMessages(&Serial, true, &PrimaryRadio)) { continue; }
+        // Drain any output still queued in this cycle's serial session before the UART clock stops.
+        OTV0P2BASE::flushSerialSCTSensitive();
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+        // Sleep until the TX instant, or until woken for I/O.
+        sleepUntilSubCycleTimeOrInt(stopBy + 1);
+#else
         // Sleep a little.
         OTV0P2BASE::nap(WDTO_15MS, true);
+#endif
         }
 
       // Send stats!
@@ -2237,6 +3281,10 @@ void loopOpenTRV()
     // This should happen as soon after the latest readings as possible (temperature especially).
     case 56:
       {
+#if defined(ENABLE_INPUT_SNAPSHOT_LOG)
+      // Log this minute's sensor snapshot before anything is computed from it.
+      logInputSnapshot();
+#endif
 #if defined(ENABLE_OCCUPANCY_SUPPORT)
       // Update occupancy measures that partially use rolling stats.
 #if defined(ENABLE_OCCUPANCY_DETECTION_FROM_RH) && defined(HUMIDITY_SENSOR_SUPPORT)
@@ -2252,10 +3300,16 @@ void loopOpenTRV()
       if(runAll && // Only if all sensors have been refreshed.
          !AmbLight.isRoomDark()) // Only if room not known to be dark, from a working sensor.
         {
-        // Only continue if temperature appears not to be falling compared to previous hour (TODO-696).
+        // Only continue if temperature appears not to be falling (TODO-696).
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+        // Use the filtered slope, which is fresher than the previous hour's stat.
+        if(TempTrend.isInitialised() && (TempTrend.getSlopeC16PerH() >= 0))
+#else
+        // Compare to previous hour.
         // No previous temperature will show as a very large number so should fail safe.
         // Note use of compress/expand to try to get round companding granularity issues.
         if(OTV0P2BASE::expandTempC16(OTV0P2BASE::compressTempC16(TemperatureC16.get())) >= OTV0P2BASE::expandTempC16(OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_TEMP_BY_HOUR, OTV0P2BASE::getPrevHourLT())))
+#endif
           {
           const uint8_t lastRH = OTV0P2BASE::getByHourStat(V0P2BASE_EE_STATS_SET_RHPC_BY_HOUR, OTV0P2BASE::getPrevHourLT());
           if((OTV0P2BASE::STATS_UNSET_BYTE != lastRH) &&
@@ -2269,11 +3323,52 @@ void loopOpenTRV()
       Occupancy.read();
 #endif // defined(ENABLE_OCCUPANCY_SUPPORT)
 
+#if defined(ENABLE_DHW_PASTEURISATION)
+      // Track pasteurisation dwell and start any due boost ahead of target recomputation.
+      Pasteuriser.tickMinute(TemperatureC16.get(), inWarmMode());
+#endif // defined(ENABLE_DHW_PASTEURISATION)
+
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+      // Refresh dew-point / mould-risk estimate ahead of target recomputation.
+      MouldRisk.update(TemperatureC16.get(), RelHumidity.get(), RelHumidity.isAvailable());
+#endif // defined(HUMIDITY_SENSOR_SUPPORT)
+
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+      // Fold in this minute's temperature ahead of target recomputation.
+      TempTrend.update(TemperatureC16.get());
+#endif // defined(ENABLE_TEMPERATURE_TREND_FILTER)
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+      // Update the self-heating estimate ahead of target recomputation; calibrate only when nothing else should move the temperature,
+      // and (on a boiler hub) pause listening only while the boiler is off so that no call for heat is missed while it runs.
+      SelfHeating.tickMinute(TemperatureC16.get(), !NominalRadValve.isCallingForHeat() && !veryRecentUIControlUse()
+#if defined(ENABLE_BOILER_HUB)
+                             && !isBoilerOn()
+#endif
+                             );
+#endif // defined(ENABLE_SELF_HEATING_COMPENSATION)
+
 #ifdef ENABLE_NOMINAL_RAD_VALVE
       // Recompute target, valve position and call for heat, etc.
       // Should be called once per minute to work correctly.
       NominalRadValve.read();
 #endif
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+      NodeHealth.tickMinute(TemperatureC16.get(), NominalRadValve.get(), NominalRadValve.isCallingForHeat());
+#endif
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+      MinOpenCal.tickMinute(NominalRadValve.get(), TempTrend.getSlopeC16PerH());
+#endif
+
+#if defined(ENABLE_URGENT_STATS_TX)
+      // Flag large valve moves and significant target changes for prompt reporting (sent after the switch below).
+      {
+      const uint8_t v = NominalRadValve.get();
+      const uint8_t dv = (v > urgentStatsTXLastValvePC) ? (v - urgentStatsTXLastValvePC) : (urgentStatsTXLastValvePC - v);
+      if(dv >= URGENT_STATS_TX_VALVE_DELTA_PC) { requestUrgentStatsTX(); }
+      if(veryRecentUIControlUse() && (NominalRadValve.getTargetTempC() != urgentStatsTXLastTargetC)) { requestUrgentStatsTX(); }
+      if(0 != urgentStatsTXHoldoffM) { --urgentStatsTXHoldoffM; }
+      }
+#endif // defined(ENABLE_URGENT_STATS_TX)
 
 #if defined(ENABLE_FHT8VSIMPLE) && defined(ENABLE_LOCAL_TRV) // Only regen when needed.
       // If there was a change in target valve position,
@@ -2339,6 +3434,36 @@ void loopOpenTRV()
       }
     }
 
+#if defined(ENABLE_URGENT_STATS_TX)
+  // Send BAKE, significant UI changes and large valve moves in this cycle, after sensor and UI handling,
+  // rather than waiting up to minutes for a random stats slot; rate-limited and jittered against collisions.
+  if(urgentStatsTXPending && (0 == urgentStatsTXHoldoffM) && enableTrailingStatsPayload() &&
+#if defined(ENABLE_FHT8VSIMPLE)
+     !(useExtraFHT8VTXSlots && localFHT8VTRVEnabled()) && // Avoid transmit conflict with FS20.
+#endif
+     (OTV0P2BASE::getSubCycleTime() < (OTV0P2BASE::GSCT_MAX >> 1))) // Else leave pending to avoid overrun.
+    {
+    urgentStatsTXPending = false;
+    urgentStatsTXHoldoffM = URGENT_STATS_TX_MIN_GAP_M;
+    // Refresh the target (not the once-per-minute valve model) so that a UI change is reported as made.
+    NominalRadValve.computeTargetTemperature();
+    // Short random wait (up to ~1/8 of the cycle) to avoid colliding with other nodes reacting to the same event.
+    const uint8_t stopBy = OTV0P2BASE::getSubCycleTime() + 1 + (((OTV0P2BASE::GSCT_MAX >> 3) | 3) & OTV0P2BASE::randRNG8());
+    while(OTV0P2BASE::getSubCycleTime() <= stopBy)
+      {
+      if(handleQueuedMessages(&Serial, true, &PrimaryRadio)) { continue; }
+      // Drain any output still queued in this cycle's serial session before the UART clock stops.
+      OTV0P2BASE::flushSerialSCTSensitive();
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+      sleepUntilSubCycleTimeOrInt(stopBy + 1);
+#else
+      OTV0P2BASE::nap(WDTO_15MS, true);
+#endif
+      }
+    bareStatsTX(!batteryLow && !inHubMode(), false);
+    }
+#endif // defined(ENABLE_URGENT_STATS_TX)
+
 #if defined(ENABLE_FHT8VSIMPLE) && defined(V0P2BASE_TWO_S_TICK_RTC_SUPPORT)
   if(useExtraFHT8VTXSlots)
     {
@@ -2371,8 +3496,9 @@ void loopOpenTRV()
 #if defined(HAS_DORM1_VALVE_DRIVE) && defined(ENABLE_LOCAL_TRV)
   // Handle local direct-drive valve, eg DORM1.
 #if defined(ENABLE_NOMINAL_RAD_VALVE)
-  // Get current modelled valve position into abstract driver.
-  ValveDirect.set(NominalRadValve.get());
+  // Get current modelled valve position into abstract driver,
+  // batching small moves to save motor energy.
+  ValveDirect.set(ValveDirectDR.update(NominalRadValve.get(), NominalRadValve.getMinValvePcReallyOpen(), veryRecentUIControlUse()));
 #endif
   // If waiting for for verification that the valve has been fitted
   // then accept any manual interaction with controls as that signal.
@@ -30,6 +30,42 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2016
 #include <OTV0p2Base.h>
 
 
+// Application-level EEPROM allocations, beyond the core OTV0p2Base layout.
+// Allocated downwards from the top of EEPROM (E2END) to keep clear of the library areas growing up from the bottom.
+// V0P2_EE_APP_LOWEST must track the lowest address allocated here.
+// Hours since last completed DHW pasteurisation cycle, saturating; 0xff if never/unknown.
+#define V0P2_EE_START_DHW_PASTEURISE_H (E2END)
+// Count of completed DHW pasteurisation cycles, inverted so that erased (0xff) reads as zero; saturates at 255.
+#define V0P2_EE_START_DHW_PASTEURISE_DONE_INV (E2END-1)
+// Count of DHW pasteurisation deadlines missed, inverted so that erased (0xff) reads as zero; saturates at 255.
+#define V0P2_EE_START_DHW_PASTEURISE_MISSED_INV (E2END-2)
+// Hours left for the alternate building key (see BuildingKeyRotation); 0xff if there is none.
+#define V0P2_EE_START_ALT_KEY_H (E2END-3)
+// Role of the alternate building key: 0 is the next key (to become primary), else the previous key.
+#define V0P2_EE_START_ALT_KEY_ROLE (E2END-4)
+// Alternate 16-byte building key.
+#define V0P2_EE_START_ALT_KEY (E2END-20)
+#define V0P2_EE_LEN_ALT_KEY 16
+// Maximum valve % open allowed, eg from hub balancing; erased (0xff) or out of range means no limit.
+#define V0P2_EE_START_MAX_VALVE_PC_OPEN (E2END-21)
+// Day of week [0,6] (arbitrary but consistent phase) advanced at local midnight in the low 3 bits,
+// and bit 3 set if last seen in the afternoon (hour >= 12) to spot midnight passing across a reset; 0xff if never set.
+#define V0P2_EE_START_DAY_OF_WEEK (E2END-22)
+// Learned minimum valve % really open (see MinOpenCalibrator), used only while no manual value is set; 0xff if none.
+#define V0P2_EE_START_LEARNED_MIN_VALVE_PC_REALLY_OPEN (E2END-23)
+// Learned self-heating gain (see SelfHeatingCompensator), C*16 at 100% activity; 0xff if not yet learned.
+#define V0P2_EE_START_SELF_HEATING_GAIN_C16 (E2END-24)
+// Hour-of-week occupancy (see HourOfWeekStats), one nibble per hour (even hours low), 0xf if unset.
+#define V0P2_EE_START_HOUR_OF_WEEK_STATS (E2END-108)
+#define V0P2_EE_LEN_HOUR_OF_WEEK_STATS 84
+#define V0P2_EE_APP_LOWEST (E2END-108)
+// Fail the build if any of this overlaps a library area: the stats (above all the fixed low items)
+// or the node associations (which also hold the per-node RX message counters).
+// These are compile-time checks on the library's own symbols so cannot pass silently if those are missing or not macros.
+static_assert(V0P2_EE_APP_LOWEST > V0P2BASE_EE_END_STATS, "application EEPROM overlaps stats area");
+static_assert(V0P2_EE_APP_LOWEST > V0P2BASE_EE_END_NODE_ASSOCIATIONS, "application EEPROM overlaps node associations area");
+
+
 // Special setup for OpenTRV beyond generic hardware setup.
 void setupOpenTRV();
 
@@ -198,6 +234,11 @@ bool setWARMTargetC(uint8_t tempC);
 #define isComfortTemperature(tempC) ((tempC) >= BIASCOM_WARM)
 
 
+// The relay role has a dependency that nothing else forces.
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY) && !defined(ENABLE_RADIO_SECONDARY_MODULE)
+#error relay role needs ENABLE_RADIO_SECONDARY_MODULE
+#endif
+
 #if defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX) || defined(ENABLE_DEFAULT_ALWAYS_RX)
 // Get minimum on (and off) time for pointer (minutes); zero if not in hub mode.
 uint8_t getMinBoilerOnMinutes();
@@ -309,6 +350,10 @@ class ModelledRadValve : public OTRadValve::AbstractRadValve
     // A value of 0 means not yet loaded from EEPROM.
     static uint8_t mVPRO_cache;
 
+    // Cache of maximum allowed valve % open [1,100] to save some EEPROM access.
+    // A value of 0 means not yet loaded from EEPROM.
+    static uint8_t mVPMO_cache;
+
     // Compute target temperature and set heat demand for TRV and boiler; update state.
     // CALL REGULARLY APPROXIMATELY ONCE PER MINUTE TO ALLOW SIMPLE TIME-BASED CONTROLS.
     // Inputs are inWarmMode(), isRoomLit().
@@ -378,11 +423,14 @@ class ModelledRadValve : public OTRadValve::AbstractRadValve
     // This may be important for systems such as district heat systems that charge by flow,
     // and other systems that prefer return temperatures to be as low as possible,
     // such as condensing boilers.
-#if defined(TRV_MAX_PC_OPEN)
-    uint8_t getMaxPercentageOpenAllowed() const { return(TRV_MAX_PC_OPEN); }
-#else
-    uint8_t getMaxPercentageOpenAllowed() const { return(100); } // TODO: make settable/persistent.
-#endif
+    // Persistent and settable (eg to apply a hub balancing limit), and never above TRV_MAX_PC_OPEN if defined.
+    static uint8_t getMaxPercentageOpenAllowed();
+
+    // Set and cache the maximum allowed percent open; 0 or >= 100 clears the limit.
+    // Values below MIN_MAX_PC_OPEN are rejected (returning false, leaving the limit unchanged)
+    // so that the valve can still really open.
+    static const uint8_t MIN_MAX_PC_OPEN = OTRadValve::DEFAULT_VALVE_PC_SAFER_OPEN;
+    static bool setMaxPercentageOpenAllowed(uint8_t percent);
 
     // Enable/disable 'glacial' mode (default false/off).
     // For heat-pump, district-heating and similar slow-reponse and pay-by-volume environments.
@@ -468,13 +516,25 @@ class ModelledRadValve : public OTRadValve::AbstractRadValve
     // Return minimum valve percentage open to be considered actually/significantly open; [1,100].
     // This is a value that has to mean all controlled valves are at least partially open if more than one valve.
     // At the boiler hub this is also the threshold percentage-open on eavesdropped requests that will call for heat.
-    // If no override is set then OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN is used.
+    // If no override is set then any learned value (see MinOpenCalibrator)
+    // else OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN is used.
     static uint8_t getMinValvePcReallyOpen();
 
     // Set and cache minimum valve percentage open to be considered really open.
     // Applies to local valve and, at hub, to calls for remote calls for heat.
-    // Any out-of-range value (eg >100) clears the override and OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN will be used.
+    // Any out-of-range value (0 or >100) clears the override and then any learned value
+    // else OTRadValve::DEFAULT_VALVE_PC_MIN_REALLY_OPEN will be used;
+    // any other value is kept as an override even if equal to the default, so that it is never silently replaced by a learned one.
     static void setMinValvePcReallyOpen(uint8_t percent);
+
+    // True if a (manual) override of the minimum valve percentage open is set.
+    static bool isMinValvePcReallyOpenSet()
+      { const uint8_t stored = eeprom_read_byte((uint8_t *)V0P2BASE_EE_START_MIN_VALVE_PC_REALLY_OPEN); return((stored > 0) && (stored <= 100)); }
+
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+    // Store the learned minimum valve percentage open, used while no override is set; [1,100].
+    static void setLearnedMinValvePcReallyOpen(uint8_t percent);
+#endif
   };
 #define ENABLE_NOMINAL_RAD_VALVE
 // Singleton implementation for entire node.
@@ -485,6 +545,538 @@ extern ModelledRadValve NominalRadValve;
 #define NominalRadValve FHT8V
 #endif
 
+#if defined(DHW_TEMPERATURES) && defined(ENABLE_MODELLED_RAD_VALVE)
+#define ENABLE_DHW_PASTEURISATION
+// Legionella control for DHW (hot water tank) builds.
+// Tracks how long since the tank last held pasteurisation temperature for the required dwell,
+// and when a cycle is due boosts the target at the learned hour needing least extra heat
+// (ie the hour at which the tank is typically warmest), or immediately if overdue.
+// A cycle achieved naturally (eg at a high comfort setting) counts just the same.
+// Automatic boosts only start and run in WARM mode, and give up after MAX_BOOST_M
+// (counted as a missed cycle) in case the tank cannot hold temperature, then retry after RETRY_H.
+// Compliance state (hours since last cycle, cycles done, deadlines missed) is kept in EEPROM
+// with about one write per hour while counting.
+class DHWPasteuriser
+  {
+  public:
+    // Pasteurisation temperature (C) that must be held for DWELL_M minutes.
+    static const uint8_t PASTEURISATION_C = 60;
+    // Target while boosting (C); a little above PASTEURISATION_C to hold above it across the deadband.
+    static const uint8_t BOOST_TARGET_C = PASTEURISATION_C + 2;
+    // Dwell at/above PASTEURISATION_C to complete a cycle (minutes, consecutive).
+    static const uint8_t DWELL_M = 60;
+    // Maximum interval between cycles (hours); weekly.
+    static const uint8_t MAX_INTERVAL_H = 7*24;
+    // Window before the deadline in which to look for the preferred hour (hours); (0,MAX_INTERVAL_H).
+    static const uint8_t WINDOW_H = 24;
+    // Longest boost (minutes) before giving up, eg with an undersized boiler or badly-placed sensor.
+    static const uint8_t MAX_BOOST_M = 180;
+    // Hours after giving up before an automatic boost may start again.
+    static const uint8_t RETRY_H = 24;
+    // Value of getPreferredHour() if there is no learned preference.
+    static const uint8_t NO_PREFERRED_HOUR = 0xff;
+
+  private:
+    // Consecutive minutes at/above PASTEURISATION_C.
+    uint8_t dwellM;
+    // True while boosting to complete a cycle, and if that boost was explicitly requested (so overrides FROST).
+    bool boosting;
+    bool forced;
+    // Minutes into the current boost.
+    uint8_t boostM;
+    // Hours left before an automatic boost may start again after giving up.
+    uint8_t retryH;
+    // Cached learned preferred hour for a boost, or NO_PREFERRED_HOUR.
+    uint8_t preferredHour;
+
+    // Record a completed cycle.
+    void completed();
+    // Record a missed cycle (a deadline passed or a boost given up).
+    static void missed();
+
+  public:
+    DHWPasteuriser() : dwellM(0), boosting(false), forced(false), boostM(0), retryH(0), preferredHour(NO_PREFERRED_HOUR) { }
+
+    // Call once per minute with the fresh tank temperature and mode, before recomputing the target.
+    void tickMinute(int16_t tempC16, bool warm);
+
+    // Call once at the end of each hour, after stats have been updated.
+    void tickHour();
+
+    // True while the target is being boosted for a pasteurisation cycle.
+    bool isBoosting() const { return(boosting); }
+
+    // Start a boost now, eg from the CLI, even in FROST mode; ends when the dwell completes or after MAX_BOOST_M.
+    void forceBoost() { boosting = true; forced = true; boostM = 0; }
+
+    // Hours since the last completed cycle; 0xff if never/unknown.
+    static uint8_t getHoursSinceLast() { return(eeprom_read_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_H)); }
+    // Count of completed cycles (saturating).
+    static uint8_t getCyclesDone() { return(~eeprom_read_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_DONE_INV)); }
+    // Count of missed deadlines and boosts given up (saturating).
+    static uint8_t getDeadlinesMissed() { return(~eeprom_read_byte((uint8_t *)V0P2_EE_START_DHW_PASTEURISE_MISSED_INV)); }
+
+    // Get the learned preferred hour [0,23] for a boost, or NO_PREFERRED_HOUR if none.
+    uint8_t getPreferredHour() const { return(preferredHour); }
+
+    // Print one-line compliance report to the specified output, eg for the CLI.
+    void report(Print *p) const;
+  };
+// Singleton implementation for entire node.
+extern DHWPasteuriser Pasteuriser;
+#endif // defined(DHW_TEMPERATURES) && defined(ENABLE_MODELLED_RAD_VALVE)
+
+#if defined(ENABLE_NODE_HEALTH_MONITOR) && !defined(ENABLE_MODELLED_RAD_VALVE)
+#undef ENABLE_NODE_HEALTH_MONITOR // Valve diagnosis needs the modelled valve.
+#endif
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+// Local self-diagnosis of likely hardware faults, reported as a small bit set in the stats stream ("hF")
+// so that a concentrator only has to look at one field per node to target maintenance visits.
+// All state is O(1) and updated once per minute/hour.
+class NodeHealthMonitor
+  {
+  public:
+    // Fault flags; any combination may be set.
+    enum flags_t
+      {
+      HF_VALVE_NO_EFFECT = 1, // Valve held well open while calling for heat but the room has not warmed.
+      HF_TEMP_FLAT = 2, // Temperature reading has not changed at all for a suspiciously long time.
+      HF_TEMP_JUMPY = 4, // Temperature reading has made implausible jumps between minutes.
+      HF_BATTERY_FAST = 8 // Battery voltage is dropping abnormally fast.
+      };
+    // Valve % at/above which it is taken to be well open.
+    static const uint8_t WELL_OPEN_PC = 50;
+    // Minutes well open and calling for heat after which the room should have warmed by MIN_RISE_C16.
+    static const uint8_t NO_EFFECT_M = 120;
+    static const int16_t MIN_RISE_C16 = 4; // 0.25C.
+    // Minutes of identical readings taken as a flatlined sensor; real sensors jitter in the lsbs.
+    static const uint16_t FLAT_M = 12*60;
+    // Minute-to-minute change (C*16) taken as an implausible jump, and number per hour to flag.
+    static const int16_t JUMP_C16 = 2*16;
+    static const uint8_t JUMPS_PER_H = 2;
+    // Battery drop (cV) between daily mean voltages BATT_DAYS apart taken as abnormally fast.
+    // Daily means smooth out the overnight temperature swing in supply voltage,
+    // and a week-long window needs a sustained ~0.02V/day drain to trip.
+    static const uint8_t BATT_DAYS = 7;
+    static const uint8_t FAST_DROP_CV_PER_WINDOW = 15;
+
+  private:
+    uint8_t flags;
+    // Minutes well open and calling for heat, and temperature at the start of that run.
+    uint8_t openM;
+    int16_t openStartC16;
+    // Last temperature (NO_READING before the first) and minutes unchanged.
+    static const int16_t NO_READING = -32767 - 1;
+    int16_t lastC16;
+    uint16_t flatM;
+    // Jumps seen this hour.
+    uint8_t jumps;
+    // Hours into the current day and sum of its hourly supply voltages (cV).
+    uint8_t battH;
+    uint16_t battSum;
+    // Whole days into the current battery window, and daily mean voltage at its start (0 if none yet).
+    uint8_t battDays;
+    uint16_t battStartcV;
+
+  public:
+    NodeHealthMonitor() : flags(0), openM(0), openStartC16(0), lastC16(NO_READING), flatM(0), jumps(0), battH(0), battSum(0), battDays(0), battStartcV(0) { }
+
+    // Call once per minute after the valve has been updated, with the current temperature (C*16).
+    void tickMinute(int16_t tempC16, uint8_t valvePC, bool callingForHeat);
+
+    // Call once per hour with the current supply voltage (cV); 0 or mains power skips the battery check.
+    void tickHour(uint16_t supplycV);
+
+    // Get the current fault flags (flags_t bits); 0 if all seems well.
+    uint8_t get() const { return(flags); }
+
+    // Returns a suggested (JSON) tag/field/key name for get(); not NULL.
+    const char *tag() const { return("hF"); }
+  };
+// Singleton implementation for entire node.
+extern NodeHealthMonitor NodeHealth;
+#endif // defined(ENABLE_NODE_HEALTH_MONITOR)
+
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+// Two-state (temperature, slope) steady-state Kalman filter, ie alpha-beta filter, of the room temperature.
+// Updated once per minute; fixed gains make it a few shifts and adds per update.
+// Tracks a steady ramp without lag, so smooths sensor jitter without delaying the valve's response,
+// and gives a per-minute slope for anticipatory decisions.
+class TemperatureTrendFilter
+  {
+  public:
+    // Log2 of the inverse position (alpha) and slope (beta) gains.
+    static const uint8_t ALPHA_SHIFT = 2;
+    static const uint8_t BETA_SHIFT = 5;
+  private:
+    // Estimated temperature (C*16*256) and slope (C*16*256 per minute).
+    int32_t x;
+    int32_t v;
+    bool initialised;
+  public:
+    TemperatureTrendFilter() : x(0), v(0), initialised(false) { }
+
+    // Call once per minute with the latest temperature (C*16).
+    void update(int16_t tempC16);
+
+    // True once at least one reading has been seen.
+    bool isInitialised() const { return(initialised); }
+
+    // Filtered temperature (C*16), rounded.
+    int16_t getC16() const { return((int16_t)((x + 128) >> 8)); }
+
+    // Estimated slope (C*16 per hour).
+    int16_t getSlopeC16PerH() const { return((int16_t)((v * 60) >> 8)); }
+  };
+// Singleton implementation for entire node.
+extern TemperatureTrendFilter TempTrend;
+#endif // defined(ENABLE_TEMPERATURE_TREND_FILTER)
+
+#if defined(ENABLE_MIN_OPEN_CALIBRATION)
+// Online calibration of the minimum really-open valve percentage.
+// Watches small openings from a cold (long-closed) radiator: if holding near the current minimum
+// makes the room temperature slope rise then the minimum is nudged down (towards that opening),
+// and if not, while the heating is known to be live (a wide opening recently warmed the room), it is nudged up.
+// Moves by 1% per observation within [MIN_PC, MAX_PC] so tracks slowly as valves age;
+// the result is persisted as a separate learned value at most once per day to limit EEPROM wear.
+// Does nothing while a manual value is set (eg with the CLI 'O' command), which always takes precedence.
+class MinOpenCalibrator
+  {
+  public:
+    // Bounds for the learned value.
+    // The upper bound is kept low so that one stiff or badly-read valve cannot lock in a wastefully high minimum.
+    static const uint8_t MIN_PC = 3;
+    static const uint8_t MAX_PC = OTRadValve::DEFAULT_VALVE_PC_SAFER_OPEN;
+    // Minutes closed for the radiator to be taken as cold, and minutes to watch an opening.
+    static const uint8_t CLOSED_M = 30;
+    static const uint8_t OBSERVE_M = 30;
+    // Opening allowed above the minimum (and drift during the watch) and still count as a small opening.
+    static const uint8_t SPAN_PC = 5;
+    // Slope rise (C*16 per hour) taken as evidence of significant flow.
+    static const int16_t RISE_C16_PER_H = 8;
+    // Valve % taken as wide open, and hours that a wide-open rise keeps the heating known to be live.
+    static const uint8_t WIDE_PC = 50;
+    static const uint8_t LIVE_H = 6;
+
+  private:
+    // Minutes closed (saturating), minutes into the current watch (0 if none), and the opening watched.
+    uint8_t closedM;
+    uint8_t watchM;
+    uint8_t watchPC;
+    // Slope when the watch started.
+    int16_t startSlope;
+    // Hours since the heating was last seen live (saturating at 255, ie unknown).
+    uint8_t liveH;
+    // Hours since last persisted.
+    uint8_t sincePersistH;
+    // Learned value (0 until first loaded).
+    uint8_t learned;
+
+  public:
+    MinOpenCalibrator()
+      : closedM(0), watchM(0), watchPC(0), startSlope(0), liveH(255), sincePersistH(0), learned(0) { }
+
+    // Call once per minute after the valve has been updated, with the trend filter slope (C*16 per hour).
+    void tickMinute(uint8_t valvePC, int16_t slopeC16PerH);
+
+    // Call once per hour; persists any change once per day.
+    void tickHour();
+
+    // Current learned value (or the value in use if nothing learned yet).
+    uint8_t get() const { return((0 != learned) ? learned : ModelledRadValve::getMinValvePcReallyOpen()); }
+  };
+// Singleton implementation for entire node.
+extern MinOpenCalibrator MinOpenCal;
+#endif // defined(ENABLE_MIN_OPEN_CALIBRATION)
+
+#if defined(ENABLE_HOUR_OF_WEEK_STATS)
+// Occupancy by hour of the week, so that eg an office stops pre-warming at the weekend
+// when the by-hour (24h) stats alone would say that Saturday 8am looks like any other 8am.
+// One smoothed nibble [0,14] per hour of the week in EEPROM, 0xf meaning no data yet.
+// Ambient light by hour of week is deliberately NOT kept: another 84 bytes would not fit above the library areas,
+// and no setback decision uses light by weekday (the 24h light stats remain).
+// The RTC only keeps time of day, so the day of week is a counter advanced at local midnight:
+// its phase is arbitrary but it need only be consistent to learn weekly patterns.
+// Which half of the day the RTC was last seen in is kept in EEPROM (written at noon and midnight only)
+// so that a midnight passed during a reset still advances the day.
+// Until every hour of a day has data its hours fold back to the 24h stats, so as not to rank against a partial day.
+class HourOfWeekStats
+  {
+  public:
+    static const uint8_t DAYS = 7;
+    static const uint8_t UNSET = 0xf;
+
+  private:
+    // Day of week [0,6], or 0xff if not yet loaded from EEPROM.
+    uint8_t dow;
+    // True if the RTC was last seen in the afternoon (as persisted).
+    bool pm;
+    // Hour of day last seen this run, to spot the 23->0 midnight rollover; 0xff if none yet.
+    uint8_t lastHH;
+    // Hour of week the cache is for (0xff if invalid), stored nibbles for that hour and the next,
+    // and their rankings within their days (see countHoursLessOccupied()), recomputed only when the hour or data change.
+    uint8_t cachedHOW;
+    uint8_t cache[2];
+    uint8_t rank[2];
+
+    // Load the day if need be and advance it past midnight.
+    void syncDay(uint8_t hh);
+    // Persist the day and half of day.
+    void persistDay();
+    // Refresh the cache for the given hour of day.
+    void refreshCache(uint8_t hh);
+    // Recompute the cached rankings from EEPROM.
+    void refreshRanks();
+
+  public:
+    HourOfWeekStats() : dow(0xff), pm(false), lastHH(0xff), cachedHOW(0xff) { }
+
+    // Day of week [0,6].
+    uint8_t getDayOfWeek() { syncDay(OTV0P2BASE::getHoursLT()); return(dow); }
+    // Set the day of week [0,6], eg to align with the calendar; ignored if out of range.
+    void setDayOfWeek(uint8_t d);
+
+    // Call with each full stats sample for the current hour: occupancy % [0,100], or 0xff for no data.
+    void sample(uint8_t occpc);
+
+    // Smoothed occupancy nibble [0,14] for this (0) or the next (1) hour of the week; UNSET if none.
+    uint8_t getOccupancy(uint8_t hourOffset);
+
+    // Count of hours on the same day of week less occupied than this (0) or the next (1) hour,
+    // comparable with countStatSamplesBelow() on the 24h stats;
+    // 0xff unless that hour and every other hour of its day have data, when the 24h stats should be used instead.
+    uint8_t countHoursLessOccupied(uint8_t hourOffset);
+  };
+// Singleton implementation for entire node.
+extern HourOfWeekStats HourOfWeek;
+#endif // defined(ENABLE_HOUR_OF_WEEK_STATS)
+
+#if defined(ENABLE_SELF_HEATING_COMPENSATION)
+// Estimate of how much a listening hub's own dissipation (radio RX, CPU awake, LEDs)
+// is warming its temperature sensor, so that a hub also running a room valve controls to the room, not itself.
+// Activity is smoothed with a first-order lag approximating the box's thermal response,
+// and scaled by a gain learned from the temperature step seen when activity switches sharply
+// (eg RX turned on or off) during quiet periods when the room itself should be nearly static.
+// Since an always-listening hub's activity never steps by itself, every CAL_INTERVAL_H hours
+// a bounded quiet window is requested in which the caller stops listening, to create a step to measure.
+// No offset is applied until a step has been measured; the learned gain is kept in EEPROM across resets.
+class SelfHeatingCompensator
+  {
+  public:
+    // Maximum self-heating (C*16) at 100% activity; ~2C has been measured for 100% RX.
+    static const uint8_t MAX_GAIN_C16 = 4*16;
+    // Log2 of the thermal lag in minutes.
+    static const uint8_t LAG_SHIFT = 4;
+    // Minute-to-minute change in activity [0,255] taken as a step worth calibrating from,
+    // and the tolerated drift afterwards.
+    static const uint8_t STEP_ACTIVITY = 192;
+    static const uint8_t STEP_DRIFT = 64;
+    // Hours between requested quiet (not listening) windows for calibration.
+    static const uint8_t CAL_INTERVAL_H = 12;
+    // Length of a quiet window (minutes): the step, a lag's worth of settling, and a little margin.
+    static const uint8_t QUIET_M = (1 << LAG_SHIFT) + 4;
+
+  private:
+    // Activity accumulated over the current minute, and cycles counted.
+    uint16_t sumActivity;
+    uint8_t cycles;
+    // Activity in the previous minute [0,255].
+    uint8_t lastActivity;
+    // Smoothed activity, 8.8 fixed point.
+    uint16_t smoothedActivity;
+    // Current gain (C*16 at 100% activity), and true once learned from at least one step.
+    uint8_t gainC16;
+    bool calibrated;
+    // Calibration in progress: minutes since step (0 if none), activity step size (signed) and starting temperature.
+    uint8_t calM;
+    int16_t calStep;
+    int16_t calStartC16;
+    // Previous minute's raw temperature.
+    int16_t lastC16;
+    // Minutes left in the current quiet window (0 if none), and hours since the last one (saturating).
+    uint8_t quietM;
+    uint8_t sinceQuietH;
+    // True once any persisted gain has been loaded.
+    bool loaded;
+
+  public:
+    SelfHeatingCompensator()
+      : sumActivity(0), cycles(0), lastActivity(0), smoothedActivity(0), gainC16(0), calibrated(false),
+        calM(0), calStep(0), calStartC16(0), lastC16(0), quietM(0), sinceQuietH(CAL_INTERVAL_H), loaded(false) { }
+
+    // Call once per main loop cycle with how busy it was [0,255], eg 255 if listening, else the sub-cycle time awake.
+    void tickCycle(const uint8_t activity) { sumActivity += activity; if(cycles < 255) { ++cycles; } }
+
+    // Call once per minute before the valve is recomputed with the raw temperature (C*16)
+    // and whether this is a quiet period (no heat call or user activity) suitable for calibration.
+    // Ends any quiet window early if no longer quiet.
+    void tickMinute(int16_t rawC16, bool quiet);
+
+    // Call once per hour to schedule quiet windows.
+    void tickHour() { if(sinceQuietH < 255) { ++sinceQuietH; } }
+
+    // True while the caller should stop listening (and otherwise stay idle) so that a step can be measured.
+    bool isQuietWindow() const { return(0 != quietM); }
+
+    // Current self-heating estimate (C*16); non-negative, and zero until calibrated.
+    uint8_t getOffsetC16() const { return((uint8_t)(((uint16_t)gainC16 * (smoothedActivity >> 8)) >> 8)); }
+
+    // Raw temperature (C*16) with the estimated self-heating removed.
+    int16_t compensate(const int16_t rawC16) const { return(rawC16 - getOffsetC16()); }
+
+    // Get the current learned gain (C*16 at 100% activity); zero until calibrated.
+    uint8_t getGainC16() const { return(gainC16); }
+
+    // True once the gain has been learned from at least one activity step.
+    bool isCalibrated() const { return(calibrated); }
+  };
+// Singleton implementation for entire node.
+extern SelfHeatingCompensator SelfHeating;
+#endif // defined(ENABLE_SELF_HEATING_COMPENSATION)
+
+#if defined(ENABLE_BOILER_HUB) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && !defined(ENABLE_TRIMMED_MEMORY)
+#define ENABLE_HYDRONIC_BALANCING
+// Hub-side hydronic balancing.
+// From the secure stats frames it hears, learns how fast each valve's room warms while its valve is well open,
+// and recommends a maximum-open limit for the rooms warming faster than the median
+// so that flow is shared and all rooms reach target together, rather than far radiators being starved.
+// Limits are reported for pushing to each valve, which applies one with setMaxPercentageOpenAllowed().
+class HydronicBalancer
+  {
+  public:
+    // Maximum number of valves tracked.
+    static const uint8_t MAX_VALVES = 8;
+    // Valve % taken as well open.
+    static const uint8_t OPEN_PC = 50;
+    // Acceptable gap between successive samples from one valve (minutes).
+    static const uint8_t MIN_GAP_M = 10;
+    static const uint8_t MAX_GAP_M = 120;
+    // Lowest limit recommended: the lowest a valve will accept (see ModelledRadValve::setMaxPercentageOpenAllowed()).
+    static const uint8_t MIN_LIMIT_PC = OTRadValve::DEFAULT_VALVE_PC_SAFER_OPEN;
+    // Hours without a stats sample after which a valve's entry is dropped, eg when removed or re-keyed.
+    static const uint8_t STALE_H = 12;
+  private:
+    struct Entry
+      {
+      uint8_t id[2]; // Leading ID bytes.
+      bool used; // True if allocated.
+      bool lastOpen; // True if the valve was well open at the last sample.
+      int16_t lastC16; // Temperature at the last sample.
+      uint16_t lastM; // Minutes since midnight at the last sample.
+      int8_t rateC16PerH; // Smoothed warm-up rate while well open; 0 if not yet known.
+      uint8_t silentH; // Whole hours since the last sample.
+      };
+    Entry valves[MAX_VALVES];
+    // Median of the known warm-up rates, 0 if none.
+    int8_t medianRate() const;
+  public:
+    HydronicBalancer() { memset(valves, 0, sizeof(valves)); }
+
+    // Note a stats sample from a remote valve: its ID, valve %, temperature (C*16) and the minutes since midnight now.
+    void noteStats(const uint8_t *id, uint8_t valvePC, int16_t tempC16, uint16_t nowM);
+
+    // Call once per hour to age entries and free those silent for STALE_H hours.
+    void tickHour();
+
+    // Recommended maximum-open limit for the given slot [MIN_LIMIT_PC,100]; 100 if unknown or slower than median.
+    uint8_t getLimitPC(uint8_t slot) const;
+
+    // Print one "=BAL id rate limit" line per valve with a known rate.
+    void report(Print *p) const;
+  };
+// Singleton implementation for entire node.
+extern HydronicBalancer Balancer;
+#endif // defined(ENABLE_BOILER_HUB) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && !defined(ENABLE_TRIMMED_MEMORY)
+
+#if defined(ENABLE_BOILER_HUB) && !defined(ENABLE_TRIMMED_MEMORY)
+#define ENABLE_BOILER_DEMAND_MODULATION
+// Continuous boiler heat-demand level [0,100] alongside the on/off OUT_HEATCALL.
+// Derived each minute from the valve openings heard over the last few minutes
+// (one TX cycle, so each valve is usually heard once), weighted towards the most-open valve,
+// since a valve's opening already reflects its room's deficit.
+// Slew-limited to avoid hunting, zero whenever the boiler is off (so existing minimum on/off times still apply),
+// and never below MIN_ON_PC while on.
+// Output on the OUT_BOILER_DEMAND_PWM pin if the board defines one, and in hub stats.
+class BoilerDemandModulator
+  {
+  public:
+    // Minutes of history (about one valve TX cycle).
+    static const uint8_t WINDOW_M = 4;
+    // Largest change per minute (percentage points).
+    static const uint8_t SLEW_PC = 10;
+    // Lowest level while on, ie the boiler's minimum modulation.
+    static const uint8_t MIN_ON_PC = 20;
+  private:
+    // Maximum valve % heard in each of the last WINDOW_M minutes, [0] being the current minute.
+    uint8_t maxPC[WINDOW_M];
+    // Sum and count of valve % heard this minute.
+    uint16_t sumPC;
+    uint8_t count;
+    // Mean valve % from the previous minute with any calls.
+    uint8_t meanPC;
+    // Current output level.
+    uint8_t level;
+  public:
+    BoilerDemandModulator() : sumPC(0), count(0), meanPC(0), level(0) { memset(maxPC, 0, sizeof(maxPC)); }
+
+    // Note a valve position heard from a remote (or the local) valve.
+    void noteValve(uint8_t percentOpen)
+      {
+      if(percentOpen > maxPC[0]) { maxPC[0] = percentOpen; }
+      if(count < 255) { sumPC += percentOpen; ++count; }
+      }
+
+    // Call once per minute with the boiler on/off state; returns the new level [0,100].
+    uint8_t tickMinute(bool boilerOn);
+
+    // Current demand level [0,100].
+    uint8_t get() const { return(level); }
+
+    // Returns a suggested (JSON) tag/field/key name for get(); not NULL.
+    const char *tag() const { return("bD|%"); }
+  };
+// Singleton implementation for entire node.
+extern BoilerDemandModulator BoilerDemand;
+#endif // defined(ENABLE_BOILER_HUB) && !defined(ENABLE_TRIMMED_MEMORY)
+
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+#define ENABLE_BUILDING_KEY_ROTATION
+// Building key rotation without a blackout.
+// A next key can be loaded in advance on every node, to replace the primary key after a set number of hours;
+// the old key is then kept as the previous key for GRACE_H so that stragglers can still be heard.
+// While an alternate (next or previous) key exists, RX tries whichever key a small per-sender hint
+// (keyed on the first ID byte) says worked last, so usually costs only one decrypt, and at most two.
+// TX always uses the primary key.
+class BuildingKeyRotation
+  {
+  public:
+    // Hours to keep accepting the previous key after rotation.
+    static const uint8_t GRACE_H = 48;
+  private:
+    // Per-sender-hint bits: set if the alternate key last worked for senders with that hint.
+    uint16_t altHint;
+    static uint8_t hintBit(const uint8_t idByte0) { return(idByte0 & 0xf); }
+  public:
+    BuildingKeyRotation() : altHint(0) { }
+    // Load the next key to replace the primary in hours [1,254]; false if hours is out of range.
+    bool setNextKey(const uint8_t *key, uint8_t hours);
+    // Forget any alternate key.
+    void clear();
+    // Call once at the end of each hour: counts down, promoting the next key or forgetting the previous one when due.
+    void tickHour();
+    // Copy the alternate key to key (16 bytes) and return true, else false if there is none.
+    bool getAltKey(uint8_t *key) const;
+    // True if the alternate key should be tried first for a sender with the given first ID byte.
+    bool isAltKeyFirst(const uint8_t idByte0) const { return(0 != (altHint & (1U << hintBit(idByte0)))); }
+    // Record which key worked for a sender with the given first ID byte.
+    void noteKeyUsed(uint8_t idByte0, bool alt);
+    // Print one line: "=KR" alone if no alternate key, else "=KR N|P hours" for a next or previous key.
+    void report(Print *p) const;
+  };
+// Singleton implementation for entire node.
+extern BuildingKeyRotation KeyRotation;
+#endif // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+
 // Sample statistics once per hour as background to simple monitoring and adaptive behaviour.
 // Call this once per hour with fullSample==true, as near the end of the hour as possible;
 // this will update the non-volatile stats record for the current hour.
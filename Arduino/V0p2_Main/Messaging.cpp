@@ -260,6 +260,28 @@ p->print("FS20 msg HC "); p->print(command.hc1); p->print(' '); p->println(comma
 #if defined(ENABLE_RADIO_RX) && defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) // && defined(ENABLE_FAST_FRAMED_CARRIER_SUPPORT)
 // Handle FS20/FHT8V traffic including binary stats.
 // Returns true on successful frame type match, false if no suitable frame was found/decoded and another parser should be tried.
+#if defined(ENABLE_HYDRONIC_BALANCING)
+// Extract the integer value of the "T|C16" field from (unterminated) JSON text; false if absent.
+static bool findJSONTempC16(const uint8_t *const json, const uint8_t len, int16_t &out)
+  {
+  static const char key[] = "\"T|C16\":";
+  const uint8_t kl = sizeof(key) - 1;
+  for(uint8_t i = 0; i + kl < len; ++i)
+    {
+    if(0 != memcmp(json + i, key, kl)) { continue; }
+    uint8_t j = i + kl;
+    const bool neg = ('-' == json[j]);
+    if(neg) { ++j; }
+    if((j >= len) || (json[j] < '0') || (json[j] > '9')) { return(false); }
+    int16_t v = 0;
+    for( ; (j < len) && (json[j] >= '0') && (json[j] <= '9'); ++j) { v = (v * 10) + (json[j] - '0'); }
+    out = neg ? -v : v;
+    return(true);
+    }
+  return(false);
+  }
+#endif // defined(ENABLE_HYDRONIC_BALANCING)
+
 static bool decodeAndHandleOTSecureableFrame(Print *p, const bool secure, const uint8_t * const msg)
   {
   const uint8_t msglen = msg[-1];
@@ -319,12 +341,41 @@ if(!isOK) { DEBUG_SERIAL_PRINTLN_FLASHSTRING("!RX bad secure header"); }
     // validate RX message counter,
     // authenticate and decrypt,
     // update RX message counter.
-    isOK = (0 != OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2::getInstance().decodeSecureSmallFrameSafely(&sfh, msg-1, msglen+1,
-                                            OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_STATELESS,
-                                            NULL, key,
-                                            secBodyBuf, sizeof(secBodyBuf), decryptedBodyOutSize,
-                                            senderNodeID,
-                                            true));
+    // During a key rotation try the key that last worked for this sender first, then the other.
+    const uint8_t *firstKey = key;
+    const uint8_t *secondKey = NULL;
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+    uint8_t altKey[16];
+    const uint8_t hintID = (sfh.getIl() > 0) ? sfh.id[0] : 0;
+    if(KeyRotation.getAltKey(altKey))
+      {
+      if(KeyRotation.isAltKeyFirst(hintID)) { firstKey = altKey; secondKey = key; }
+      else { secondKey = altKey; }
+      }
+#endif
+    {
+#if defined(ENABLE_CPU_CLOCK_BURST)
+    OTV0P2BASE::flushSerialSCTSensitive(); // Serial must be idle while the clock is boosted.
+    // Until the end of this scope: no serial, _delay_*() or cycle-count timing; pin-change ISRs (radio RX) deferred.
+    CPUClockBurst fast(!Supply_cV.isSupplyVoltageLow());
+#endif
+    for(const uint8_t *k = firstKey; NULL != k; k = (k == firstKey) ? secondKey : NULL)
+      {
+      isOK = (0 != OTRadioLink::SimpleSecureFrame32or0BodyRXV0p2::getInstance().decodeSecureSmallFrameSafely(&sfh, msg-1, msglen+1,
+                                              OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_STATELESS,
+                                              NULL, k,
+                                              secBodyBuf, sizeof(secBodyBuf), decryptedBodyOutSize,
+                                              senderNodeID,
+                                              true));
+      if(isOK)
+        {
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+        if(NULL != secondKey) { KeyRotation.noteKeyUsed(hintID, (k == altKey)); }
+#endif
+        break;
+        }
+      }
+    }
 #if 1 // && defined(DEBUG)
     if(!isOK)
       {
@@ -406,8 +457,14 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("!RX O short"); // "O' frame too short.
       // else print directly to console/Serial.
       if((0 != (secBodyBuf[1] & 0x10)) && (decryptedBodyOutSize > 3) && ('{' == secBodyBuf[2]))
         {
+#if defined(ENABLE_HYDRONIC_BALANCING)
+        // Learn this room's warm-up rate for balancing.
+        int16_t tempC16;
+        if((percentOpen <= 100) && findJSONTempC16(secBodyBuf + 3, decryptedBodyOutSize - 3, tempC16))
+          { Balancer.noteStats(senderNodeID, percentOpen, tempC16, OTV0P2BASE::getMinutesSinceMidnightLT()); }
+#endif // defined(ENABLE_HYDRONIC_BALANCING)
 #ifdef ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY
-        SecondaryRadio.queueToSend(msg, msglen); 
+        Relay.relay(msg, msglen);
 #else // Don't write to console/Serial also if relayed.
         // Write out the JSON message, inserting synthetic ID/@ and seq/+.
         Serial.print(F("{\"@\":\""));
@@ -525,7 +582,7 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Stats IDx");
           }
         // FIXME should only relay authenticated (and encrypted) traffic.
         // Relay stats frame over secondary radio.
-        SecondaryRadio.queueToSend(buf, buflen); 
+        Relay.relay(buf, buflen);
 #else // Don't write to console/Serial also if relayed.
         // Write out the JSON message.
         OTV0P2BASE::outputJSONStats(&Serial, secure, msg, msglen);
@@ -547,6 +604,184 @@ DEBUG_SERIAL_PRINTLN_FLASHSTRING("Stats IDx");
   }
 #endif // ENABLE_RADIO_RX
 
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+FrameRelay Relay;
+
+// RX ISR filter: records arrival of a frame, or sheds it while the uplink is lagging.
+bool FrameRelay::filterRXISR(const volatile uint8_t *, volatile uint8_t &)
+  {
+  if(0 != Relay.backoff) { ++Relay.shed; return(false); }
+  // If the queue of times is full (eg frames dropped after this filter) overwrite the oldest.
+  if(Relay.rxCount >= RX_TIMES) { Relay.rxHead = (Relay.rxHead + 1) % RX_TIMES; --Relay.rxCount; }
+  Relay.rxTimes[(Relay.rxHead + Relay.rxCount) % RX_TIMES] = Relay.now();
+  ++Relay.rxCount;
+  return(true);
+  }
+
+// Call once per frame taken from the RX queue.
+void FrameRelay::frameDone()
+  {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+    if(0 != rxCount) { rxHead = (rxHead + 1) % RX_TIMES; --rxCount; }
+    }
+  }
+
+// Queue the given frame on the secondary link and start sending it at once.
+bool FrameRelay::relay(const uint8_t *const buf, const uint8_t buflen)
+  {
+  if(!SecondaryRadio.queueToSend(buf, buflen))
+    {
+    ++refused;
+    backoff = BACKOFF_CYCLES;
+    return(false);
+    }
+  // Start the uplink now rather than waiting for the next routine poll.
+  SecondaryRadio.poll();
+  ++relayed;
+  // Latency from RX ISR arrival of the frame being handled, if known.
+  bool haveRXTime = false;
+  uint16_t rxTime = 0;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+    if(0 != rxCount) { haveRXTime = true; rxTime = rxTimes[rxHead]; }
+    }
+  if(haveRXTime)
+    {
+    const uint16_t latency = now() - rxTime;
+    uint8_t b = 0;
+    while((b < LAT_BUCKETS-1) && (latency >= (1U << b))) { ++b; }
+    ++latHist[b];
+    }
+  return(true);
+  }
+
+// Call once at the start of each minor cycle.
+void FrameRelay::tickCycle()
+  {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+    ++cycles;
+    if(0 != backoff) { --backoff; }
+    }
+  }
+
+// Print one line: "=RL relayed refused shed p50 p90 p99".
+void FrameRelay::report(Print *const p)
+  {
+  uint16_t s;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { s = shed; }
+  p->print(F("=RL "));
+  p->print(relayed);
+  p->print(' ');
+  p->print(refused);
+  p->print(' ');
+  p->print(s);
+  uint32_t total = 0;
+  for(uint8_t i = 0; i < LAT_BUCKETS; ++i) { total += latHist[i]; }
+  static const uint8_t pcs[] = { 50, 90, 99 };
+  for(uint8_t j = 0; j < sizeof(pcs); ++j)
+    {
+    p->print(' ');
+    if(0 == total) { p->print('-'); continue; }
+    // Smallest bucket at or below which at least pcs[j]% of latencies fall.
+    const uint32_t target = (total * pcs[j] + 99) / 100;
+    uint32_t cum = 0;
+    uint8_t b = 0;
+    for( ; b < LAT_BUCKETS-1; ++b) { if((cum += latHist[b]) >= target) { break; } }
+    if(b < LAT_BUCKETS-1) { p->print(1U << b); } else { p->print('>'); p->print((1U << (LAT_BUCKETS-2)) - 1); }
+    }
+  p->println();
+  }
+#endif // defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+AdaptiveRXPoll RXPoll;
+
+// Call when a received frame has been handled.
+void AdaptiveRXPoll::frameHandled()
+  {
+  // Frames often come in bursts (eg double TX), so poll fast for a while.
+  level = 0;
+  quietNaps = 0;
+  if((maxLevel < MAX_LEVEL) && (++cleanFrames >= CLEAN_FRAMES_TO_RELAX))
+    {
+    cleanFrames = 0;
+    ++maxLevel;
+    }
+  }
+
+// Check for missed frames then nap for the current interval.
+void AdaptiveRXPoll::napAndAdapt(OTRadioLink::OTRadioLink *const rl)
+  {
+  const uint8_t dropped = rl->getRXMsgsDroppedRecent();
+  uint8_t lost = (uint8_t)(dropped - lastDropped);
+  lastDropped = dropped;
+  // Drain RX errors (eg FIFO overrun from a late poll) as possible losses.
+  while(0 != rl->getRXErr()) { if(lost < 255) { ++lost; } }
+  if(0 != lost)
+    {
+    // Frames possibly lost: poll fast and stop stretching the interval so far.
+    missed += lost;
+    if(maxLevel > 0) { --maxLevel; }
+    level = 0;
+    quietNaps = 0;
+    cleanFrames = 0;
+    }
+  else if((level < maxLevel) && (++quietNaps >= QUIET_NAPS_TO_LENGTHEN))
+    {
+    quietNaps = 0;
+    ++level;
+    }
+  // WDTO_15MS and WDTO_30MS are consecutive.
+  OTV0P2BASE::nap(WDTO_15MS + level, true);
+  }
+#endif // defined(ENABLE_ADAPTIVE_RX_POLL)
+
+#if defined(ENABLE_RX_LOAD_METRICS)
+RXLoadMetrics RXMetrics;
+
+// Decode and handle one frame, folding the time taken into RXMetrics.
+static void timedDecodeAndHandleRawRXedMessage(Print *p, const bool secure, const uint8_t * const msg)
+  {
+  const uint8_t sctStart = OTV0P2BASE::getSubCycleTime();
+  decodeAndHandleRawRXedMessage(p, secure, msg);
+  const uint8_t ticks = OTV0P2BASE::getSubCycleTime() - sctStart;
+  ++RXMetrics.handled;
+  RXMetrics.totalTicks += ticks;
+  if(ticks > RXMetrics.maxTicks) { RXMetrics.maxTicks = ticks; }
+  }
+
+// Decode and handle a raw frame as if just received, timed into RXMetrics.
+void replayRawRXMessage(Print *p, const uint8_t * const msg) { timedDecodeAndHandleRawRXedMessage(p, false, msg); }
+
+// Print RX load metrics as one line.
+void printRXLoadMetrics(Print *const p, OTRadioLink::OTRadioLink *const rl)
+  {
+  p->print(F("=RX "));
+  p->print(RXMetrics.handled);
+  p->print(' ');
+  p->print(RXMetrics.deferred);
+  p->print(' ');
+  p->print(RXMetrics.maxTicks);
+  p->print(' ');
+  p->print(RXMetrics.totalTicks);
+  p->print(' ');
+  p->print(rl->getRXMsgsDroppedRecent());
+  p->print(' ');
+  p->print(rl->getRXMsgsFilteredRecent());
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+  p->print(' ');
+  p->print(RXPoll.getMissed());
+  p->print(' ');
+  p->print(RXPoll.getLevel());
+#endif
+  p->println();
+  }
+#else
+#define timedDecodeAndHandleRawRXedMessage(p, secure, msg) decodeAndHandleRawRXedMessage((p), (secure), (msg))
+#endif // defined(ENABLE_RX_LOAD_METRICS)
+
 #ifdef ENABLE_RADIO_RX
 // Incrementally process I/O and queued messages, including from the radio link.
 // This may mean printing them to Serial (which the passed Print object usually is),
@@ -569,7 +804,13 @@ bool handleQueuedMessages(Print *p, bool wakeSerialIfNeeded, OTRadioLink::OTRadi
   // Allow for up to 0.5s of such processing worst-case,
   // ie don't start processing anything later that 0.5s before the minor cycle end.
   const uint8_t sctStart = OTV0P2BASE::getSubCycleTime();
-  if(sctStart >= ((OTV0P2BASE::GSCT_MAX/4)*3)) { return(false); }
+  if(sctStart >= ((OTV0P2BASE::GSCT_MAX/4)*3))
+    {
+#if defined(ENABLE_RX_LOAD_METRICS)
+    if(NULL != rl->peekRXMsg()) { ++RXMetrics.deferred; }
+#endif
+    return(false);
+    }
 
   // Deal with any I/O that is queued.
   bool workDone = pollIO(true);
@@ -577,22 +818,25 @@ bool handleQueuedMessages(Print *p, bool wakeSerialIfNeeded, OTRadioLink::OTRadi
   // Check for activity on the radio link.
   rl->poll();
 
-  bool neededWaking = false; // Set true once this routine wakes Serial.
   const volatile uint8_t *pb;
   if(NULL != (pb = rl->peekRXMsg()))
     {
-    if(!neededWaking && wakeSerialIfNeeded && OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>()) { neededWaking = true; } // FIXME
+    // Serial is kept up for the handling, and released as per SerialSession.
+    SerialSession session(wakeSerialIfNeeded);
     // Don't currently regard anything arriving over the air as 'secure'.
     // FIXME: shouldn't have to cast away volatile to process the message content.
-    decodeAndHandleRawRXedMessage(p, false, (const uint8_t *)pb);
+    timedDecodeAndHandleRawRXedMessage(p, false, (const uint8_t *)pb);
     rl->removeRXMsg();
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+    Relay.frameDone();
+#endif
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+    RXPoll.frameHandled();
+#endif
     // Note that some work has been done.
     workDone = true;
     }
 
-  // Turn off serial at end, if this routine woke it.
-  if(neededWaking) { OTV0P2BASE::flushSerialProductive(); OTV0P2BASE::powerDownSerial(); }
-
 #if 0 && defined(DEBUG)
   const uint8_t sctEnd = OTV0P2BASE::getSubCycleTime();
   const uint8_t ticks = sctEnd - sctStart;
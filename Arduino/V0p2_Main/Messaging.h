@@ -141,5 +141,118 @@ bool handleQueuedMessages(Print *p, bool wakeSerialIfNeeded, OTRadioLink::OTRadi
 #define handleQueuedMessages(p, wakeSerialIfNeeded, rl) (false)
 #endif
 
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+// Relays received frames over the secondary link as soon as they are decoded,
+// shedding new RX frames at the ISR for a short while after the uplink refuses one (backpressure),
+// and keeping a histogram of latency from RX ISR to hand-off to the uplink.
+class FrameRelay
+  {
+  public:
+    // Minor cycles to shed new RX frames after the uplink refuses one.
+    static const uint8_t BACKOFF_CYCLES = 2;
+    // Latency buckets: bucket i holds latencies < 1<<i sub-cycle ticks, except the last which holds the rest.
+    static const uint8_t LAT_BUCKETS = 10;
+  private:
+    // RX ISR arrival times (minor cycle count << 8 | sub-cycle ticks) of queued frames, oldest first.
+    static const uint8_t RX_TIMES = 4;
+    volatile uint16_t rxTimes[RX_TIMES];
+    volatile uint8_t rxHead, rxCount;
+    // Minor cycle count, for the high byte of arrival times; wraps.
+    volatile uint8_t cycles;
+    // Non-zero while shedding RX frames.
+    volatile uint8_t backoff;
+    // Counts; all wrap.
+    uint16_t relayed, refused;
+    volatile uint16_t shed;
+    uint16_t latHist[LAT_BUCKETS];
+    // Current time as minor cycle count << 8 | sub-cycle ticks.
+    uint16_t now() const { return((((uint16_t)cycles) << 8) | OTV0P2BASE::getSubCycleTime()); }
+  public:
+    FrameRelay() : rxHead(0), rxCount(0), cycles(0), backoff(0), relayed(0), refused(0), shed(0), latHist() { }
+    // RX ISR filter: records arrival of a frame, or returns false to shed it while the uplink is lagging.
+    // Suitable for OTRadioLink::setFilterRXISR().
+    static bool filterRXISR(const volatile uint8_t *buf, volatile uint8_t &buflen);
+    // Call once per frame taken from the RX queue, after it has been handled (relayed or not).
+    void frameDone();
+    // Queue the given frame on the secondary link and start sending it at once; false if refused.
+    bool relay(const uint8_t *buf, uint8_t buflen);
+    // Call once at the start of each minor cycle.
+    void tickCycle();
+    // True if currently shedding RX frames because the uplink is lagging.
+    bool isLagging() const { return(0 != backoff); }
+    // Print one line: "=RL relayed refused shed p50 p90 p99", percentiles as upper bounds in sub-cycle ticks.
+    void report(Print *p);
+  };
+extern FrameRelay Relay;
+#endif // defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+
+#if defined(ENABLE_ADAPTIVE_RX_POLL)
+// Without a radio RX interrupt a listening node must wake and poll the radio frequently,
+// but the radio holds a complete received frame until read, so the poll interval can stretch while the air is quiet.
+// This adapts the nap between polls (15/30ms) to observed traffic:
+// dropping to the shortest after any frame, lengthening gradually while quiet,
+// and lowering the longest allowed nap on any sign of loss.
+// Late polling itself is not counted by the radio's queue-full drop count,
+// so loss is also taken from the radio's RX error reports (eg FIFO overrun),
+// which err on the side of polling fast as they include noise and bad frames too.
+// The longest nap is capped at 30ms: it is only reached after about 0.5s of silence
+// and any frame drops straight back to 15ms, so only the first frame after a quiet spell
+// leaves the radio deaf for up to 15ms longer than the fixed 15ms nap did.
+class AdaptiveRXPoll
+  {
+  public:
+    // Longest nap level allowed; level L naps for WDTO_15MS+L, ie 15ms<<L.
+    static const uint8_t MAX_LEVEL = 1;
+    // Consecutive quiet naps at one level before trying the next longer one.
+    static const uint8_t QUIET_NAPS_TO_LENGTHEN = 32;
+    // Frames handled with none missed before allowing a longer maximum nap again.
+    static const uint8_t CLEAN_FRAMES_TO_RELAX = 64;
+  private:
+    uint8_t level;
+    uint8_t maxLevel;
+    uint8_t quietNaps;
+    uint8_t cleanFrames;
+    // Last seen value of the radio's (wrapping) dropped-frame count.
+    uint8_t lastDropped;
+    // Frames dropped or RX errors seen, ie possible missed frames; wraps.
+    uint16_t missed;
+  public:
+    AdaptiveRXPoll() : level(0), maxLevel(MAX_LEVEL), quietNaps(0), cleanFrames(0), lastDropped(0), missed(0) { }
+    // Call when a received frame has been handled.
+    void frameHandled();
+    // Check for missed frames then nap for the current interval, waking early on any interrupt.
+    void napAndAdapt(OTRadioLink::OTRadioLink *rl);
+    // Current nap level [0,MAX_LEVEL].
+    uint8_t getLevel() const { return(level); }
+    // Frames dropped or RX errors seen, ie possible missed frames.
+    uint16_t getMissed() const { return(missed); }
+  };
+extern AdaptiveRXPoll RXPoll;
+#endif // defined(ENABLE_ADAPTIVE_RX_POLL)
+
+#if defined(ENABLE_RX_LOAD_METRICS)
+// Cumulative RX handling load metrics, eg to find the frame rate at which a hub saturates.
+// Times are in sub-cycle ticks (see OTV0P2BASE::getSubCycleTime()) and include any serial output.
+struct RXLoadMetrics
+  {
+  // Frames taken from the RX queue (or replayed) and decoded; wraps.
+  uint16_t handled;
+  // Polls skipped late in the minor cycle while a frame was waiting; wraps.
+  uint16_t deferred;
+  // Worst-case ticks to decode and handle one frame.
+  uint8_t maxTicks;
+  // Total ticks spent decoding and handling frames; wraps.
+  uint32_t totalTicks;
+  };
+extern RXLoadMetrics RXMetrics;
+// Print RX load metrics as one line, including radio queue drop/filter counts:
+//     "=RX handled deferred maxTicks totalTicks dropped filtered"
+// with adaptive RX polling also appending " missed napLevel".
+void printRXLoadMetrics(Print *p, OTRadioLink::OTRadioLink *rl);
+// Decode and handle a raw frame (msg[-1] contains the length) as if just received, timed into RXMetrics.
+// Allows a frame stream to be replayed into a real hub at a controlled rate, eg from the CLI.
+void replayRawRXMessage(Print *p, const uint8_t *msg);
+#endif // defined(ENABLE_RX_LOAD_METRICS)
+
 
 #endif
@@ -467,6 +467,35 @@ void checkUserSchedule()
 #endif // !defined(checkUserSchedule)
 
 
+#if defined(ENABLE_RX_LOAD_METRICS) || defined(ENABLE_BUILDING_KEY_ROTATION)
+// Parse exactly 2*n hex digits from hex into n bytes at out; false if any is not a hex digit.
+// out may overlap hex provided that out <= hex+1, since each byte is written after its digits are read.
+static bool parseHexBytes(const char *const hex, uint8_t *const out, const uint8_t n)
+  {
+  for(uint8_t i = 0; i < n; ++i)
+    {
+    uint8_t b = 0;
+    for(uint8_t j = 0; j < 2; ++j)
+      {
+      const char c = hex[2*i + j];
+      b <<= 4;
+      if((c >= '0') && (c <= '9')) { b |= c - '0'; }
+      else if((c >= 'a') && (c <= 'f')) { b |= c - 'a' + 10; }
+      else if((c >= 'A') && (c <= 'F')) { b |= c - 'A' + 10; }
+      else { return(false); }
+      }
+    out[i] = b;
+    }
+  return(true);
+  }
+#endif
+
+#if defined(ENABLE_EXTENDED_CLI) || defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+static const uint8_t MAXIMUM_CLI_RESPONSE_CHARS = 1 + OTV0P2BASE::CLI::MAX_TYPICAL_CLI_BUFFER;
+#else
+static const uint8_t MAXIMUM_CLI_RESPONSE_CHARS = 1 + OTV0P2BASE::CLI::MIN_TYPICAL_CLI_BUFFER;
+#endif
+
 #ifdef ENABLE_EXTENDED_CLI
 // Handle CLI extension commands.
 // Commands of form:
@@ -474,11 +503,120 @@ void checkUserSchedule()
 // where EXT is the name of the extension, usually 3 letters.
 
 #include <OTProtocolCC.h>
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+#include <OTAESGCM.h>
+#endif
 
 // It is acceptable for extCLIHandler() to alter the buffer passed,
 // eg with strtok_t().
 static bool extCLIHandler(Print *const p, char *const buf, const uint8_t n)
   {
+#if defined(ENABLE_RX_LOAD_METRICS)
+  // +RXL N HEX
+  // Replay the raw frame given as hex (without length byte) up to N times (1--255)
+  // through the RX decode path back-to-back, then print the RX load metrics,
+  // so that a captured frame stream can be used to find a hub's saturation point.
+  // The whole command must fit the CLI buffer, limiting frames to RXL_MAX_FRAME_BYTES:
+  // enough for FS20/FHT8V and short insecure frames, but NOT for secure 'O' frames,
+  // which would anyway be rejected by replay protection after the first.
+  // A command that fills the buffer may have been truncated so is refused with "!RXL max N".
+  static const uint8_t RXL_MAX_FRAME_BYTES = (MAXIMUM_CLI_RESPONSE_CHARS - 1 - 9) / 2; // Allows for "+RXL 255 ".
+  if((n >= 9) && (0 == strncmp_P(buf, PSTR("+RXL "), 5)))
+    {
+    if(n >= MAXIMUM_CLI_RESPONSE_CHARS) { p->print(F("!RXL max ")); p->println(RXL_MAX_FRAME_BYTES); return(true); }
+    char *last; // Used by strtok_r().
+    char *tok1, *tok2;
+    if((NULL == (tok1 = strtok_r(buf+5, " ", &last))) ||
+       (NULL == (tok2 = strtok_r(NULL, " ", &last)))) { return(false); }
+    const uint8_t reps = (uint8_t) atoi(tok1);
+    const uint8_t hexLen = strlen(tok2);
+    if((0 == reps) || (0 == hexLen) || (0 != (hexLen & 1))) { return(false); }
+    // Decode the hex in place after a length byte, which always fits behind the hex text.
+    uint8_t *const frame = (uint8_t *)tok2;
+    const uint8_t frameLen = hexLen / 2;
+    if(!parseHexBytes(tok2, frame+1, frameLen)) { return(false); }
+    frame[0] = frameLen;
+    // As for queued RX, stop late in the minor cycle to avoid an overrun; 'handled' shows how many ran.
+    for(uint8_t r = reps; r-- > 0; )
+      {
+      if(OTV0P2BASE::getSubCycleTime() >= ((OTV0P2BASE::GSCT_MAX/4)*3)) { break; }
+      replayRawRXMessage(p, frame+1);
+      }
+    printRXLoadMetrics(p, &PrimaryRadio);
+    return(true);
+    }
+#endif // defined(ENABLE_RX_LOAD_METRICS)
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
+  // +AES N
+  // Time up to N (1--255) encrypt+decrypt pairs of a fixed 32-byte body
+  // with the OTAESGCM stateless routines and print approximate CPU cycles per frame for each:
+  //     "=AES n encCycles decCycles"
+  // and, with CPU clock bursts, also wall-clock ms per pair at the normal and boosted clock:
+  //     "=AES n encCycles decCycles pairMs burstPairMs"
+  // Uses a dummy key; stops early rather than overrun the minor cycle, so check n.
+  if((n >= 6) && (0 == strncmp_P(buf, PSTR("+AES "), 5)))
+    {
+    const uint8_t reps = (uint8_t) atoi(buf+5);
+    if(0 == reps) { return(false); }
+    static const uint8_t key[16] = { };
+    static const uint8_t iv[12] = { };
+    static const uint8_t authtext[8] = { };
+    uint8_t text[32] = { };
+    uint8_t ctext[32];
+    uint8_t tag[16];
+    // Approximate CPU cycles per sub-cycle tick.
+    const uint32_t cyclesPerTick = (F_CPU * (uint32_t)OTV0P2BASE::MAIN_TICK_S) / (OTV0P2BASE::GSCT_MAX + 1U);
+    const uint8_t stopBy = (OTV0P2BASE::GSCT_MAX/4)*3;
+    uint8_t done = 0;
+    uint16_t encTicks = 0, decTicks = 0;
+    while((done < reps) && (OTV0P2BASE::getSubCycleTime() < stopBy))
+      {
+      const uint8_t t0 = OTV0P2BASE::getSubCycleTime();
+      if(!OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_STATELESS(NULL, key, iv, authtext, sizeof(authtext), text, ctext, tag)) { return(false); }
+      const uint8_t t1 = OTV0P2BASE::getSubCycleTime();
+      if(!OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_STATELESS(NULL, key, iv, authtext, sizeof(authtext), ctext, tag, text)) { return(false); }
+      const uint8_t t2 = OTV0P2BASE::getSubCycleTime();
+      encTicks += (uint8_t)(t1 - t0);
+      decTicks += (uint8_t)(t2 - t1);
+      ++done;
+      }
+    if(0 == done) { return(false); }
+    p->print(F("=AES "));
+    p->print(done);
+    p->print(' ');
+    p->print((encTicks * cyclesPerTick) / done);
+    p->print(' ');
+#if !defined(ENABLE_CPU_CLOCK_BURST)
+    p->println((decTicks * cyclesPerTick) / done);
+#else
+    p->print((decTicks * cyclesPerTick) / done);
+    // Repeat the same number of pairs with the clock boosted as for real frames,
+    // and append wall-clock ms per pair without and with the boost,
+    // from which race-to-sleep energy can be estimated given active supply current at each clock.
+    OTV0P2BASE::flushSerialSCTSensitive();
+    uint16_t burstTicks = 0;
+    uint8_t burstDone = 0;
+      {
+      CPUClockBurst fast;
+      while((burstDone < done) && (OTV0P2BASE::getSubCycleTime() < stopBy))
+        {
+        ++burstDone;
+        const uint8_t t0 = OTV0P2BASE::getSubCycleTime();
+        OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_STATELESS(NULL, key, iv, authtext, sizeof(authtext), text, ctext, tag);
+        OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_STATELESS(NULL, key, iv, authtext, sizeof(authtext), ctext, tag, text);
+        burstTicks += (uint8_t)(OTV0P2BASE::getSubCycleTime() - t0);
+        }
+      }
+    const uint16_t msPerTick1000 = (1000000UL * OTV0P2BASE::MAIN_TICK_S) / (OTV0P2BASE::GSCT_MAX + 1U);
+    p->print(' ');
+    p->print(((uint32_t)(encTicks + decTicks) * msPerTick1000) / (1000UL * done));
+    p->print(' ');
+    if(0 != burstDone) { p->print(((uint32_t)burstTicks * msPerTick1000) / (1000UL * burstDone)); }
+    p->println();
+#endif // !defined(ENABLE_CPU_CLOCK_BURST)
+    return(true);
+    }
+#endif // defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
   return(false); // FAILED if not otherwise handled.
   }
 #endif 
@@ -534,7 +672,7 @@ HChc1 hc2 are the house codes 1 and 2 for an FHT8V valve.
 */
 void serialStatusReport()
   {
-  const bool neededWaking = OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>(); // FIXME
+  SerialSession session;
 
   // Aim to overlap CPU usage with characters being TXed for throughput determined primarily by output size and baud.
 
@@ -675,8 +813,6 @@ void serialStatusReport()
 
   // Ensure that all text is sent before this routine returns, in case any sleep/powerdown follows that kills the UART.
   OTV0P2BASE::flushSerialSCTSensitive();
-
-  if(neededWaking) { OTV0P2BASE::powerDownSerial(); }
   }
 #endif // defined(ENABLE_SERIAL_STATUS_REPORT) && !defined(serialStatusReport)
 
@@ -737,6 +873,9 @@ static void dumpCLIUsage(const uint8_t stopBy)
 #ifdef ENABLE_FULL_OT_CLI
   // Optional CLI features...
   Serial.println(F("-"));
+#if defined(ENABLE_RX_LOAD_METRICS) || defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY) || defined(ENABLE_HYDRONIC_BALANCING)
+  printCLILine(deadline, 'B', F("hub RX load/relay/Balancing report"));
+#endif
 #if defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX)
   printCLILine(deadline, F("C M"), F("Central hub >=M mins on, 0 off"));
 #endif
@@ -751,6 +890,12 @@ static void dumpCLIUsage(const uint8_t stopBy)
   printCLILine(deadline, F("L S"), F("Learn daily warm now, clear if in frost mode, schedule S"));
   //printCLILine(deadline, F("P HH MM"), F("Program: warm daily starting at HH MM schedule 0"));
   printCLILine(deadline, F("P HH MM S"), F("Program: warm daily starting at HH MM schedule S"));
+#endif
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+  printCLILine(deadline, F("N K H"), F("set Next key K (hex) in H hours; N * clear"));
+#endif
+#if defined(ENABLE_MODELLED_RAD_VALVE) && !defined(ENABLE_TRIMMED_MEMORY)
+  printCLILine(deadline, F("M PP"), F("Max % valve open; M clears"));
 #endif
   printCLILine(deadline, F("O PP"), F("min % for valve to be Open"));
 #if defined(ENABLE_NOMINAL_RAD_VALVE)
@@ -760,6 +905,10 @@ static void dumpCLIUsage(const uint8_t stopBy)
 //  printCLILine(deadline, F("R N"), F("dump Raw stats set N"));
 
   printCLILine(deadline, F("T HH MM"), F("set 24h Time"));
+#if defined(ENABLE_DHW_PASTEURISATION)
+  printCLILine(deadline, 'U', F("pasteUrisation report"));
+  printCLILine(deadline, F("U!"), F("start pasteUrisation boost"));
+#endif
   printCLILine(deadline, 'W', F("Warm"));
 #if defined(ENABLE_SETTABLE_TARGET_TEMPERATURES) && !defined(TEMP_POT_AVAILABLE)
   printCLILine(deadline, F("W CC"), F("set Warm temp CC"));
@@ -773,11 +922,6 @@ static void dumpCLIUsage(const uint8_t stopBy)
   Serial.println();
   }
 
-#if defined(ENABLE_EXTENDED_CLI) || defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT)
-static const uint8_t MAXIMUM_CLI_RESPONSE_CHARS = 1 + OTV0P2BASE::CLI::MAX_TYPICAL_CLI_BUFFER;
-#else
-static const uint8_t MAXIMUM_CLI_RESPONSE_CHARS = 1 + OTV0P2BASE::CLI::MIN_TYPICAL_CLI_BUFFER;
-#endif
 // Used to poll user side for CLI input until specified sub-cycle time.
 // Commands should be sent terminated by CR *or* LF; both may prevent 'E' (exit) from working properly.
 // A period of less than (say) 500ms will be difficult for direct human response on a raw terminal.
@@ -796,7 +940,7 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
       }
     }
 
-  const bool neededWaking = OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>();
+  SerialSession session;
 
   // Wait for input command line from the user (received characters may already have been queued)...
   // Read a line up to a terminating CR, either on its own or as part of CRLF.
@@ -856,6 +1000,24 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
         break; // Note that status is by default printed after processing input line.
         }
 
+#if defined(ENABLE_RX_LOAD_METRICS) || defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY) || defined(ENABLE_HYDRONIC_BALANCING)
+      // Hub report: RX load, relay and balancing lines, kept out of the 'S' output parsed by status tools.
+      case 'B':
+        {
+#if defined(ENABLE_RX_LOAD_METRICS)
+        printRXLoadMetrics(&Serial, &PrimaryRadio);
+#endif
+#if defined(ENABLE_RADIO_SECONDARY_MODULE_AS_RELAY)
+        Relay.report(&Serial);
+#endif
+#if defined(ENABLE_HYDRONIC_BALANCING)
+        Balancer.report(&Serial);
+#endif
+        showStatus = false;
+        break;
+        }
+#endif
+
 #if !defined(ENABLE_TRIMMED_MEMORY)
       // Version information printed as one line to serial, machine- and human- parseable.
       case 'V':
@@ -964,6 +1126,38 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
       case 'K': { showStatus = OTV0P2BASE::CLI::SetSecretKey(OTRadioLink::SimpleSecureFrame32or0BodyTXV0p2::resetRaw3BytePersistentTXRestartCounterCond).doCommand(buf, n); break; }
 #endif // ENABLE_OTSECUREFRAME_ENCODING_SUPPORT
 
+#if defined(ENABLE_BUILDING_KEY_ROTATION)
+      // N KKKK...KK H
+      // Load Next building key (32 hex digits) to replace the current one in H hours (1--254).
+      // N *
+      // Clear any next/previous key.
+      // N
+      // Report key rotation state (never the key itself).
+      case 'N':
+        {
+        char *last; // Used by strtok_r().
+        char *tok1;
+        char *tok2;
+        if((n >= 3) && (NULL != (tok1 = strtok_r(buf+2, " ", &last))))
+          {
+          if(('*' == tok1[0]) && ('\0' == tok1[1])) { KeyRotation.clear(); }
+          else
+            {
+            uint8_t key[16];
+            if((32 == strlen(tok1)) && parseHexBytes(tok1, key, sizeof(key)) &&
+               (NULL != (tok2 = strtok_r(NULL, " ", &last))))
+              {
+              const int h = atoi(tok2);
+              if((h < 1) || (h > 254) || !KeyRotation.setNextKey(key, (uint8_t)h)) { OTV0P2BASE::CLI::InvalidIgnored(); }
+              }
+            else { OTV0P2BASE::CLI::InvalidIgnored(); }
+            }
+          }
+        KeyRotation.report(&Serial);
+        break;
+        }
+#endif // defined(ENABLE_BUILDING_KEY_ROTATION)
+
 #ifdef ENABLE_LEARN_BUTTON
       // Learn current settings, just as if primary/specified LEARN button had been pressed.
       case 'L':
@@ -983,6 +1177,22 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
         }
 #endif // ENABLE_LEARN_BUTTON
 
+#if defined(ENABLE_MODELLED_RAD_VALVE) && !defined(ENABLE_TRIMMED_MEMORY)
+      // Set/clear max-valve-open-% limit, eg as recommended by hub balancing.
+      case 'M':
+        {
+        int maxPcOpen = 0; // Will clear the limit.
+        char *last; // Used by strtok_r().
+        char *tok1;
+        if((n > 1) && (NULL != (tok1 = strtok_r(buf+2, " ", &last))))
+          { maxPcOpen = atoi(tok1); }
+        // Range-check before narrowing, else eg 300 would wrap to 44%; too-low limits are also refused.
+        if((maxPcOpen < 0) || (maxPcOpen > 100) || !NominalRadValve.setMaxPercentageOpenAllowed((uint8_t)maxPcOpen))
+          { OTV0P2BASE::CLI::InvalidIgnored(); }
+        break;
+        }
+#endif
+
 #if defined(ENABLE_NOMINAL_RAD_VALVE) && !defined(ENABLE_TRIMMED_MEMORY)
       // Set/clear min-valve-open-% threshold override.
       case 'O':
@@ -1038,6 +1248,18 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
       case 'T': { showStatus = OTV0P2BASE::CLI::SetTime().doCommand(buf, n); break; }
 #endif // !defined(ENABLE_TRIMMED_MEMORY)
 
+#if defined(ENABLE_DHW_PASTEURISATION)
+      // Show DHW pasteurisation (Legionella control) compliance: U
+      // With U! start a boost now.
+      case 'U':
+        {
+        if((n == 2) && ('!' == buf[1])) { Pasteuriser.forceBoost(); }
+        Pasteuriser.report(&Serial);
+        showStatus = false;
+        break;
+        }
+#endif // defined(ENABLE_DHW_PASTEURISATION)
+
 #if defined(ENABLE_LOCAL_TRV)
       // Switch to WARM (not BAKE) mode OR set WARM temperature.
       case 'W':
@@ -1083,6 +1305,4 @@ void pollCLI(const uint8_t maxSCT, const bool startOfMinute)
 
   // Force any pending output before return / possible UART power-down.
   OTV0P2BASE::flushSerialSCTSensitive();
-
-  if(neededWaking) { OTV0P2BASE::powerDownSerial(); }
   }
@@ -49,6 +49,7 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2016
 #include "Schedule.h"
 #include "Security.h"
 #include "UI_Minimal.h"
+#include "V0p2_Sensors.h"
 
 
 // Error exit from failed unit test, one int parameter and the failing line number to print...
@@ -293,6 +294,63 @@ static void testComputeRequiredTRVPercentOpen()
 #endif // ENABLE_MODELLED_RAD_VALVE
   }
 
+#ifdef ENABLE_MODELLED_RAD_VALVE
+// Closed-loop 'what-if' run of the real valve control against a crude simulated room.
+// The room is first-order: the radiator heat delivered is proportional to valve % open
+// and heat is lost in proportion to the inside/outside difference;
+// at 100% open the room would settle ~25C above outside, so the valve must regulate.
+// Reports energy (valve-%-minutes), comfort (minutes more than 1C below target once warm)
+// and boiler calls (transitions into really-open) for comparing control tweaks,
+// and asserts only gross sanity so as to stay robust to tuning.
+static void testValveRoomSimulation()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("ValveRoomSimulation");
+  static const int16_t outsideC256 = 5 << 8;
+  static const uint16_t simMins = 6 * 60;
+  static const uint16_t warmUpMins = 2 * 60;
+  int16_t roomC256 = 15 << 8; // Start cold.
+  ModelledRadValveInputState is(roomC256 >> 4);
+  is.targetTempC = WARM;
+  ModelledRadValveState rs;
+  volatile uint8_t valvePCOpen = 0;
+  uint32_t energyPCMins = 0;
+  uint16_t coldMins = 0;
+  uint8_t boilerCalls = 0;
+  bool wasOpen = false;
+  for(uint16_t m = 0; m < simMins; ++m)
+    {
+    // Simulates one minute on each iteration.
+    is.refTempC16 = roomC256 >> 4;
+    rs.tick(valvePCOpen, is);
+    const uint8_t v = valvePCOpen;
+    AssertIsTrue(v <= 100);
+    energyPCMins += v;
+    const bool isOpen = (v >= is.minPCOpen);
+    if(isOpen && !wasOpen) { ++boilerCalls; }
+    wasOpen = isOpen;
+    roomC256 += (int16_t)v - ((roomC256 - outsideC256) / 64);
+    if((m >= warmUpMins) && ((roomC256 >> 8) < (int16_t)is.targetTempC - 1)) { ++coldMins; }
+    // Must never overheat grossly.
+    AssertIsTrueWithErr((roomC256 >> 8) <= (int16_t)is.targetTempC + 3, roomC256 >> 8);
+    }
+  DEBUG_SERIAL_PRINT_FLASHSTRING("sim E");
+  DEBUG_SERIAL_PRINT(energyPCMins);
+  DEBUG_SERIAL_PRINT_FLASHSTRING(" cold ");
+  DEBUG_SERIAL_PRINT(coldMins);
+  DEBUG_SERIAL_PRINT_FLASHSTRING(" calls ");
+  DEBUG_SERIAL_PRINT(boilerCalls);
+  DEBUG_SERIAL_PRINT_FLASHSTRING(" moved ");
+  DEBUG_SERIAL_PRINT(rs.cumulativeMovementPC);
+  DEBUG_SERIAL_PRINTLN();
+  // Once warmed up the room should be held close to target.
+  AssertIsTrueWithErr(coldMins < 10, coldMins);
+  // Must not be calling for heat more often than about every half hour on average.
+  AssertIsTrueWithErr(boilerCalls <= (simMins / 30), boilerCalls);
+  // Some heat must have been needed to hold the room well above outside.
+  AssertIsTrue(energyPCMins > 0);
+  }
+#endif // ENABLE_MODELLED_RAD_VALVE
+
 
 // Test set derived from following status lines from a hard-to-regulate-smoothly unit DHD20141230
 // (poor static balancing, direct radiative heat, low thermal mass, insufficiently insulated?):
@@ -1272,6 +1330,43 @@ void testSleepUntilSubCycleTime()
 #endif
   }
 
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+// Test sleepUntilSubCycleTimeOrInt() routine.
+static void testSleepUntilSubCycleTimeOrInt()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("SleepUntilSubCycleTimeOrInt");
+
+  const uint8_t start = OTV0P2BASE::getSubCycleTime();
+
+  // Check that this correctly notices/vetoes attempt to sleep until time already past, leaving the compare interrupt off.
+  AssertIsTrue(!sleepUntilSubCycleTimeOrInt(0));
+  if(start > 0) { AssertIsTrue(!sleepUntilSubCycleTimeOrInt(start-1)); }
+  AssertIsTrue(0 == (TIMSK2 & _BV(OCIE2A)));
+
+  // Don't attempt rest of test if near the end of the current minor cycle...
+  if(start > (OTV0P2BASE::GSCT_MAX/2)) { return; }
+
+  // Set a random target significantly before the end of the current minor cycle.
+  const uint8_t target = start + 2 + (OTV0P2BASE::randRNG8() & 0x3f);
+  AssertIsTrue(target < OTV0P2BASE::GSCT_MAX);
+
+  // Any other interrupt may wake this early, so sleep again until the target is reported as reached;
+  // each call must leave the compare interrupt off.
+  uint8_t calls = 0;
+  while(sleepUntilSubCycleTimeOrInt(target))
+    {
+    AssertIsTrue(0 == (TIMSK2 & _BV(OCIE2A)));
+    AssertIsTrue(++calls < 100);
+    }
+  AssertIsTrue(calls > 0);
+  AssertIsTrue(0 == (TIMSK2 & _BV(OCIE2A)));
+
+  // Should have woken at or just after the target, and certainly not slept through to the next cycle.
+  const uint8_t end = OTV0P2BASE::getSubCycleTime();
+  AssertIsTrueWithErr((end >= target) && (end <= target + 2), end);
+  }
+#endif
+
 // Test that the simple smoothing function never generates an out of range value.
 // In particular, with a legitimate value range of [0,254]
 // smoothStatsValue() must never generate 255 (0xff) which looks like an uninitialised EEPROM value,
@@ -1303,6 +1398,107 @@ static void testTempCompand()
   AssertIsTrue(OTV0P2BASE::STATS_UNSET_INT == expandTempC16(OTV0P2BASE::STATS_UNSET_BYTE));
   }
 
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+// Test fixed-point dew point and mould-risk hysteresis.
+static void testMouldRisk()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("MouldRisk");
+  // Compare against floating-point Magnus formula results, to within 0.5C.
+  AssertIsEqualWithDelta(148, MouldRiskEstimator::computeDewPointC16(20<<4, 50), 8);
+  AssertIsEqualWithDelta(263, MouldRiskEstimator::computeDewPointC16(20<<4, 80), 8);
+  AssertIsEqualWithDelta(20<<4, MouldRiskEstimator::computeDewPointC16(20<<4, 100), 8);
+  AssertIsEqualWithDelta(136, MouldRiskEstimator::computeDewPointC16(10<<4, 90), 8);
+  AssertIsEqualWithDelta(-147, MouldRiskEstimator::computeDewPointC16(0, 50), 8);
+  // Damp room goes straight to mould risk and imposes a floor above the room temperature.
+  MouldRiskEstimator mr;
+  AssertIsEqual(MouldRiskEstimator::MR_NONE, mr.get());
+  AssertIsEqual(0, mr.getFloorC());
+  AssertIsEqual(MouldRiskEstimator::MR_MOULD, mr.update(20<<4, 80, true));
+  AssertIsTrue(mr.getFloorC() > 20);
+  // Dry room steps down one level at a time.
+  AssertIsEqual(MouldRiskEstimator::MR_ELEVATED, mr.update(20<<4, 50, true));
+  AssertIsEqual(MouldRiskEstimator::MR_NONE, mr.update(20<<4, 50, true));
+  AssertIsEqual(0, mr.getFloorC());
+  // No RH% means no risk asserted.
+  mr.update(20<<4, 80, true);
+  AssertIsEqual(MouldRiskEstimator::MR_NONE, mr.update(20<<4, 80, false));
+  }
+#endif
+
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+// Test the temperature/slope filter tracks a ramp without lag and smooths jitter.
+static void testTemperatureTrendFilter()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("TemperatureTrendFilter");
+  TemperatureTrendFilter f;
+  AssertIsTrue(!f.isInitialised());
+  // Steady rise of 1/16C per minute, ie 60 C*16 per hour.
+  for(int16_t m = 0; m < 90; ++m) { f.update((18<<4) + m); }
+  AssertIsTrue(f.isInitialised());
+  AssertIsEqualWithDelta((18<<4) + 89, f.getC16(), 1);
+  AssertIsEqualWithDelta(60, f.getSlopeC16PerH(), 2);
+  // Flat with +/- 1lsb jitter: settles near the mean with near-zero slope.
+  for(int16_t m = 0; m < 120; ++m) { f.update((20<<4) + ((m & 1) ? 1 : -1)); }
+  AssertIsEqualWithDelta((20<<4), f.getC16(), 1);
+  AssertIsEqualWithDelta(0, f.getSlopeC16PerH(), 4);
+  }
+#endif
+
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+// Test the modulated boiler demand against a trivial boiler stand-in: ramps, holds, decays, and is off with the boiler.
+static void testBoilerDemandModulator()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("BoilerDemandModulator");
+  BoilerDemandModulator bd;
+  bd.noteValve(100);
+  AssertIsEqual(0, bd.tickMinute(false)); // Boiler off: no demand regardless of valves.
+  bd.noteValve(100);
+  AssertIsEqual(BoilerDemandModulator::MIN_ON_PC + BoilerDemandModulator::SLEW_PC, bd.tickMinute(true));
+  for(uint8_t m = 0; m < 10; ++m) { bd.noteValve(100); bd.tickMinute(true); }
+  AssertIsEqual(100, bd.get());
+  // Demand is held across a valve TX cycle, then eases down towards the minimum.
+  AssertIsEqual(100, bd.tickMinute(true));
+  for(uint8_t m = 0; m < 20; ++m) { bd.tickMinute(true); }
+  AssertIsEqual(BoilerDemandModulator::MIN_ON_PC, bd.get());
+  AssertIsEqual(0, bd.tickMinute(false));
+  }
+#endif
+
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+// Test node self-diagnosis of stuck valve, flatlined/jumpy sensor and fast battery drain.
+static void testNodeHealthMonitor()
+  {
+  DEBUG_SERIAL_PRINTLN_FLASHSTRING("NodeHealthMonitor");
+  NodeHealthMonitor nh;
+  AssertIsEqual(0, nh.get());
+  // Valve well open and calling for heat for a long time with the room (jittering but) not warming.
+  for(uint8_t m = 0; m < NodeHealthMonitor::NO_EFFECT_M; ++m) { nh.tickMinute((18<<4) + (m & 1), 100, true); }
+  AssertIsEqual(NodeHealthMonitor::HF_VALVE_NO_EFFECT, nh.get());
+  // Room then warms: cleared.
+  nh.tickMinute((19<<4), 100, true);
+  AssertIsEqual(0, nh.get());
+  // Implausible jumps within an hour.
+  nh.tickMinute((25<<4), 0, false);
+  nh.tickMinute((19<<4), 0, false);
+  nh.tickHour(0);
+  AssertIsEqual(NodeHealthMonitor::HF_TEMP_JUMPY, nh.get());
+  nh.tickHour(0);
+  AssertIsEqual(0, nh.get());
+  // Flatlined readings.
+  for(uint16_t m = 0; m < NodeHealthMonitor::FLAT_M; ++m) { nh.tickMinute((19<<4), 0, false); }
+  AssertIsEqual(NodeHealthMonitor::HF_TEMP_FLAT, nh.get());
+  nh.tickMinute((19<<4) + 1, 0, false);
+  AssertIsEqual(0, nh.get());
+  // Battery with a large overnight swing but no underlying drain over more than a week: not flagged.
+  for(uint16_t h = 0; h < 24*(NodeHealthMonitor::BATT_DAYS+1); ++h) { nh.tickHour(((h % 24) < 12) ? 290 : 310); }
+  AssertIsEqual(0, nh.get());
+  // Battery steadily falling 0.03V/day with the same swing: flagged once a full window has elapsed.
+  nh.tickHour(0);
+  for(uint16_t h = 0; h < 24*(NodeHealthMonitor::BATT_DAYS+1); ++h) { nh.tickHour(300 - 3*(h/24) + (((h % 24) < 12) ? -10 : 10)); }
+  AssertIsEqual(NodeHealthMonitor::HF_BATTERY_FAST, nh.get());
+  }
+#endif
+
 // Test some of the mask/port calculations.
 static void testFastDigitalIOCalcs()
   {
@@ -1427,6 +1623,9 @@ void loopUnitTest()
   // Run the tests, fastest / newest / most-fragile / most-interesting first...
   testLibVersions();
   testComputeRequiredTRVPercentOpen();
+#ifdef ENABLE_MODELLED_RAD_VALVE
+  testValveRoomSimulation();
+#endif
   testFastDigitalIOCalcs();
   testTargetComputation();
   testModeControls();
@@ -1435,7 +1634,22 @@ void loopUnitTest()
   testFullStatsMessageCoreEncDec();
   testTempCompand();
   testSmoothStatsValue();
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+  testMouldRisk();
+#endif
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER)
+  testTemperatureTrendFilter();
+#endif
+#if defined(ENABLE_BOILER_DEMAND_MODULATION)
+  testBoilerDemandModulator();
+#endif
+#if defined(ENABLE_NODE_HEALTH_MONITOR)
+  testNodeHealthMonitor();
+#endif
   testSleepUntilSubCycleTime();
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+  testSleepUntilSubCycleTimeOrInt();
+#endif
   testFHTEncoding();
   testFHTEncodingHeadAndTail();
   testSensorMocking();
@@ -188,6 +188,81 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2016
 #endif // defined(ENABLE_STATS_RX)
 #endif // ENABLE_FHT8VSIMPLE
 
+// If able to RX and not short of memory, keep RX handling load metrics to help find a hub's saturation point.
+#if defined(ENABLE_RADIO_RX) && !defined(ENABLE_TRIMMED_MEMORY)
+#define ENABLE_RX_LOAD_METRICS
+#endif
+
+// If doing secure frames on a 1MHz CPU then briefly run faster for crypto bursts to get back to sleep sooner.
+#if defined(ENABLE_OTSECUREFRAME_ENCODING_SUPPORT) && (1000000L == F_CPU) && !defined(DISABLE_CPU_CLOCK_BURST)
+#define ENABLE_CPU_CLOCK_BURST
+#endif
+
+// If sending stats from a local valve then send promptly (not in the next random slot) on BAKE, UI changes and big valve moves.
+#if defined(ENABLE_STATS_TX) && defined(ENABLE_LOCAL_TRV) && !defined(DISABLE_URGENT_STATS_TX)
+#define ENABLE_URGENT_STATS_TX
+#endif
+
+// If listening continuously, adapt the radio poll interval to traffic when polling (without an RX interrupt);
+// see V0p2_Main.h for the pin-dependent part.  DISABLE_ADAPTIVE_RX_POLL keeps the fixed 15ms poll.
+#if defined(ENABLE_CONTINUOUS_RX) && !defined(DISABLE_ADAPTIVE_RX_POLL)
+#define ENABLE_ADAPTIVE_RX_POLL
+#endif
+
+// If the async 32768Hz timer is running, sleep until an exact sub-cycle time (eg for TX jitter) rather than in 15ms naps,
+// unless continuous RX without a radio interrupt pin needs frequent polling anyway (see V0p2_Main.h).
+#if defined(ENABLE_WAKEUP_32768HZ_XTAL)
+#define ENABLE_PRECISE_SUBCYCLE_SLEEP
+#endif
+
+// Uncomment to filter the room temperature (and get its slope) with a trend filter for valve control;
+// changes valve behaviour so off by default.  Needs a local valve; DISABLE_TEMPERATURE_TREND_FILTER forces it off.
+//#define ENABLE_TEMPERATURE_TREND_FILTER
+#if defined(ENABLE_TEMPERATURE_TREND_FILTER) && (!defined(ENABLE_LOCAL_TRV) || defined(DISABLE_TEMPERATURE_TREND_FILTER))
+#undef ENABLE_TEMPERATURE_TREND_FILTER
+#endif
+
+// Uncomment to learn the minimum really-open valve % from the room's response (needs the trend filter above);
+// changes valve behaviour so off by default.  A manual value (CLI 'O') always takes precedence.
+// DISABLE_MIN_OPEN_CALIBRATION forces it off.
+//#define ENABLE_MIN_OPEN_CALIBRATION
+#if defined(ENABLE_MIN_OPEN_CALIBRATION) && (!defined(ENABLE_TEMPERATURE_TREND_FILTER) || !defined(ENABLE_LOCAL_TRV) || defined(DISABLE_MIN_OPEN_CALIBRATION))
+#undef ENABLE_MIN_OPEN_CALIBRATION
+#endif
+
+// Uncomment to compensate a listening hub's own self-heating in the local valve's reference temperature;
+// changes valve behaviour so off by default, and applies no offset until learned.
+// DISABLE_SELF_HEATING_COMPENSATION forces it off.
+//#define ENABLE_SELF_HEATING_COMPENSATION
+#if defined(ENABLE_SELF_HEATING_COMPENSATION) && (!defined(ENABLE_CONTINUOUS_RX) || !defined(ENABLE_LOCAL_TRV) || defined(DISABLE_SELF_HEATING_COMPENSATION))
+#undef ENABLE_SELF_HEATING_COMPENSATION
+#endif
+
+// Uncomment to learn occupancy by hour of the week and use it for setback look-ahead (eg no weekend pre-warm for offices);
+// changes setback behaviour so off by default.  DISABLE_HOUR_OF_WEEK_STATS forces it off.
+//#define ENABLE_HOUR_OF_WEEK_STATS
+#if defined(ENABLE_HOUR_OF_WEEK_STATS) && (!defined(ENABLE_OCCUPANCY_SUPPORT) || defined(ENABLE_TRIMMED_MEMORY) || defined(DISABLE_HOUR_OF_WEEK_STATS))
+#undef ENABLE_HOUR_OF_WEEK_STATS
+#endif
+
+// Uncomment to report the mould-risk level as "mR" in the stats of nodes with a humidity sensor;
+// adds a stat to every TX so off by default (the estimate still limits setbacks locally).
+// DISABLE_MOULD_RISK_STATS forces it off.
+//#define ENABLE_MOULD_RISK_STATS
+#if defined(ENABLE_MOULD_RISK_STATS) && (!defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21) || defined(DISABLE_MOULD_RISK_STATS))
+#undef ENABLE_MOULD_RISK_STATS
+#endif
+
+// Uncomment to have a local valve diagnose likely hardware faults and report them as "hF" in its stats;
+// adds a stat to every TX so off by default.  DISABLE_NODE_HEALTH_MONITOR forces it off.
+//#define ENABLE_NODE_HEALTH_MONITOR
+#if defined(ENABLE_NODE_HEALTH_MONITOR) && (!defined(ENABLE_LOCAL_TRV) || defined(DISABLE_NODE_HEALTH_MONITOR))
+#undef ENABLE_NODE_HEALTH_MONITOR
+#endif
+
+// Uncomment to log a per-minute sensor/mode snapshot and PRNG reseeds to serial for offline analysis; dev only, costs power.
+//#define ENABLE_INPUT_SNAPSHOT_LOG
+
 // If in stats or boiler hub mode, and with an FS20 OOK carrier, then apply a trailing-zeros RX filter.
 #if (defined(ENABLE_BOILER_HUB) || defined(ENABLE_STATS_RX)) && defined(LISTEN_FOR_FTp2_FS20_native)
 #define CONFIG_TRAILING_ZEROS_FILTER_RX
@@ -48,6 +48,16 @@ Author(s) / Copyright (s): Damon Hart-Davis 2013--2016
 #include "V0p2_Generic_Config.h" // Config switches and module dependencies.
 #include <OTV0p2_Board_IO_Config.h> // I/O pin allocation and setup: include ahead of I/O module headers.
 
+// Consequential definitions that also depend on the I/O pin allocation.
+#if defined(PIN_RFM_NIRQ)
+// With a radio RX interrupt there is no frequent polling to adapt.
+#undef ENABLE_ADAPTIVE_RX_POLL
+#endif
+#if defined(ENABLE_CONTINUOUS_RX) && !defined(PIN_RFM_NIRQ)
+// Without a radio RX interrupt, continuous RX must poll in short naps anyway.
+#undef ENABLE_PRECISE_SUBCYCLE_SLEEP
+#endif
+
 // Link in support for alternate Power On Self-Test (startup) and main loop if required.
 #if defined(ALT_MAIN_LOOP) // Exclude code from production systems.
 extern void POSTalt();
@@ -92,6 +102,75 @@ inline void burnHundredsOfCyclesProductivelyAndPoll()
   else { OTV0P2BASE::captureEntropy1(); }
   }
 
+#if defined(ENABLE_CPU_CLOCK_BURST)
+// Runs the CPU at 4MHz rather than 1MHz while this object is in scope,
+// for short bursts of compute such as AES-GCM, so as to get back to sleep sooner.
+// 4MHz (8MHz internal RC / 2) stays within spec down to 1.8V, but pass enable false if the supply is low anyway.
+// The RTC and sub-cycle time run from the async 32768Hz timer so are unaffected.
+// Timer0 (millis()) is kept at its usual rate by raising its prescaler from /64 to /256 for the burst;
+// if Timer0 is running at any other prescale, which cannot be scaled exactly, no burst is done.
+// Pin-change interrupts (including the radio's nIRQ and the mode button) are masked for the burst
+// and any latched meanwhile are serviced at the normal clock when it ends,
+// so that no ISR runs F_CPU-based _delay_*() or SPI timing at the wrong speed.
+// INVALID within the scope: serial I/O (must be flushed beforehand; wrong baud rate),
+// any F_CPU-based busy-wait (_delay_*(), delayMicroseconds()) and timing by CPU cycle count.
+// Safe to nest; not to be used from an ISR.
+class CPUClockBurst
+  {
+  private:
+    // CLKPR prescaler bits to restore, or 0xff if left unchanged.
+    uint8_t savedCLKPS;
+    // Timer0 clock select and pin-change interrupt enables to restore.
+    uint8_t savedTCCR0B;
+    uint8_t savedPCICR;
+    // Not copyable.
+    CPUClockBurst(const CPUClockBurst &);
+    CPUClockBurst &operator=(const CPUClockBurst &);
+  public:
+    explicit CPUClockBurst(bool enable = true);
+    ~CPUClockBurst();
+  };
+#endif // defined(ENABLE_CPU_CLOCK_BURST)
+
+// Scoped use of the UART, coalesced across a main loop cycle.
+// Between beginCycle() and endCycle() the UART is powered up by the first user that needs it
+// and left up for later users, then drained and powered down once by endCycle() before the loop sleeps;
+// outside that window (eg during the end-of-cycle sleep/poll loop) each session powers down again on exit if it woke the UART.
+// Users should still flush their output before any sleep.
+// Not to be used from an ISR.
+class SerialSession
+  {
+  private:
+    // True between beginCycle() and endCycle().
+    static bool coalescing;
+    // True if any session woke the UART since beginCycle().
+    static bool woken;
+    // True if this session woke the UART.
+    const bool neededWaking;
+    // Not copyable.
+    SerialSession(const SerialSession &);
+    SerialSession &operator=(const SerialSession &);
+  public:
+    // Powers up the UART if needed (and wake is true).
+    explicit SerialSession(bool wake = true)
+      : neededWaking(wake && OTV0P2BASE::powerUpSerialIfDisabled<V0P2_UART_BAUD>())
+      { if(neededWaking) { woken = true; } }
+    ~SerialSession()
+      { if(neededWaking && !coalescing) { OTV0P2BASE::flushSerialProductive(); OTV0P2BASE::powerDownSerial(); } }
+    // Call at the start of the work in each main loop cycle.
+    static void beginCycle() { coalescing = true; woken = false; }
+    // Call once at the end of the work in each main loop cycle, before sleeping; leaves the UART off.
+    static void endCycle();
+  };
+
+#if defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+// Sleep in power-save mode until the sub-cycle time reaches sct or any interrupt (eg from the radio) arrives,
+// whichever is first, using a Timer2 compare match so that there are no periodic watchdog wakeups.
+// Serial output should be flushed first as the UART clock stops.
+// Returns false without sleeping if sct has already been reached.
+bool sleepUntilSubCycleTimeOrInt(uint8_t sct);
+#endif // defined(ENABLE_PRECISE_SUBCYCLE_SLEEP)
+
 #ifndef DEBUG
 #define DEBUG_SERIAL_PRINT(s) // Do nothing.
 #define DEBUG_SERIAL_PRINTFMT(s, format) // Do nothing.
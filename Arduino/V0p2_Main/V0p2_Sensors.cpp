@@ -116,6 +116,62 @@ OTV0P2BASE::HumiditySensorSHT21 RelHumidity;
 OTV0P2BASE::DummyHumiditySensorSHT21 RelHumidity;
 #endif
 
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+// Singleton implementation/instance.
+MouldRiskEstimator MouldRisk;
+
+// -ln(RH/100)*256 at RH = 10, 20, ... 100%, for linear interpolation.
+static const uint16_t negLnRH256[10] PROGMEM = { 589, 412, 308, 235, 177, 131, 91, 57, 27, 0 };
+
+// Compute dew point (C*16) from temperature (C*16) and RH% using a fixed-point Magnus approximation.
+// With b = 17.62 and c = 243.12C:
+//     gamma = ln(RH/100) + b*T/(c+T);  Td = c*gamma/(b-gamma)
+// with gamma carried as a value *256 and c scaled to C*16 (3890).
+int16_t MouldRiskEstimator::computeDewPointC16(const int16_t tempC16, const uint8_t rh)
+  {
+  const uint8_t r = OTV0P2BASE::fnmax((uint8_t)10, OTV0P2BASE::fnmin(rh, (uint8_t)100));
+  const uint8_t i = r / 10;
+  const uint8_t f = r % 10;
+  const uint16_t lo = pgm_read_word(&negLnRH256[i-1]);
+  const uint16_t hi = (i < 10) ? pgm_read_word(&negLnRH256[i]) : 0;
+  const int16_t negLn256 = (int16_t)(lo - (((lo - hi) * f) / 10));
+  const int32_t gamma256 = ((int32_t)4511 * tempC16) / (3890 + tempC16) - negLn256;
+  return((int16_t)((3890 * gamma256) / (4511 - gamma256)));
+  }
+
+// Update the estimate from fresh temperature (C*16) and RH% values.
+uint8_t MouldRiskEstimator::update(const int16_t tempC16, const uint8_t rh, const bool rhAvailable)
+  {
+  if(!rhAvailable) { risk = MR_NONE; return(risk); }
+  dewPointC16 = computeDewPointC16(tempC16, rh);
+  // Margin of assumed cold surface above dew point.
+  const int16_t margin = tempC16 - COLD_SURFACE_DELTA_C16 - dewPointC16;
+  // Raw level without hysteresis.
+  const uint8_t raw = (margin < 0) ? MR_CONDENSATION :
+                      ((margin < MOULD_MARGIN_C16) ? MR_MOULD :
+                      ((margin < MOULD_MARGIN_C16 + ELEVATED_EXTRA_C16) ? MR_ELEVATED : MR_NONE));
+  if(raw >= risk) { risk = raw; }
+  else
+    {
+    // Only drop one level at a time, and then only when clear of that level's threshold by the hysteresis margin.
+    const int16_t threshold = (MR_CONDENSATION == risk) ? 0 :
+                              ((MR_MOULD == risk) ? MOULD_MARGIN_C16 : (MOULD_MARGIN_C16 + ELEVATED_EXTRA_C16));
+    if(margin >= threshold + HYST_C16) { --risk; }
+    }
+  return(risk);
+  }
+
+// Get minimum room air temperature (whole C, rounded up) to keep cold surfaces below ~80% RH, or 0 if none needed.
+// Applied while the risk is at all elevated so that holding at the floor does not itself release the floor.
+uint8_t MouldRiskEstimator::getFloorC() const
+  {
+  if(MR_NONE == risk) { return(0); }
+  const int16_t floorC16 = dewPointC16 + COLD_SURFACE_DELTA_C16 + MOULD_MARGIN_C16;
+  if(floorC16 <= 0) { return(0); }
+  return((uint8_t)OTV0P2BASE::fnmin((floorC16 + 15) >> 4, 255));
+  }
+#endif // defined(HUMIDITY_SENSOR_SUPPORT)
+
 
 // Ambient/room temperature sensor, usually on main board.
 #if defined(ENABLE_PRIMARY_TEMP_SENSOR_SHT21)
@@ -148,6 +204,27 @@ OTRadValve::ValveMotorDirectV1<MOTOR_DRIVE_ML, MOTOR_DRIVE_MR, MOTOR_DRIVE_MI_AI
 #else
 OTRadValve::ValveMotorDirectV1<MOTOR_DRIVE_MR, MOTOR_DRIVE_ML, MOTOR_DRIVE_MI_AIN, MOTOR_DRIVE_MC_AIN> ValveDirect;
 #endif // HAS_DORM1_MOTOR_REVERSED
+
+// Singleton implementation/instance.
+ValveDeadReckoning ValveDirectDR;
+
+// Given the new target [0,100], return the position to hand to the driver.
+uint8_t ValveDeadReckoning::update(const uint8_t targetPC, const uint8_t minReallyOpenPC, const bool urgent)
+  {
+  if(targetPC == committedPC) { return(committedPC); }
+  const uint8_t travel = (targetPC > committedPC) ? (targetPC - committedPC) : (committedPC - targetPC);
+  const bool endStop = (0 == targetPC) || (100 == targetPC);
+  const bool crossesReallyOpen = ((targetPC >= minReallyOpenPC) != (committedPC >= minReallyOpenPC));
+  // Threshold for small moves widens with estimated error.
+  const uint8_t threshold = OTV0P2BASE::fnmax(MIN_MOVE_PC, getErrorPC());
+  if(!urgent && !endStop && !crossesReallyOpen && (travel < threshold)) { return(committedPC); }
+  committedPC = targetPC;
+  // Running into an end stop re-references the position.
+  if(endStop) { errPC16 = 0; }
+  else { errPC16 = OTV0P2BASE::fnmin((uint16_t)(errPC16 + ERR_PER_MOVE_PC16 + ((travel << 4) >> ERR_TRAVEL_SHIFT)), (uint16_t)(100 << 4)); }
+  return(committedPC);
+  }
+
 #endif
 
 
@@ -117,6 +117,72 @@ extern OTV0P2BASE::HumiditySensorSHT21 RelHumidity;
 extern OTV0P2BASE::DummyHumiditySensorSHT21 RelHumidity;
 #endif
 
+#if defined(HUMIDITY_SENSOR_SUPPORT)
+// Pseudo-sensor estimating dew point and surface condensation / mould risk from room temperature and RH%.
+// All fixed-point (no float) and cheap enough to run once per minute.
+// Risk is assessed at an assumed cold surface (eg external wall corner, window reveal)
+// somewhat colder than the air at the sensor, using the common criterion
+// that mould can grow where surface RH stays at/above ~80%.
+// Levels change with hysteresis to avoid flapping between adjacent levels.
+// Also provides a floor temperature for setbacks so that they do not push the room into mould risk.
+class MouldRiskEstimator
+  {
+  public:
+    // Risk levels, in increasing order of severity.
+    enum risk_t
+      {
+      MR_NONE = 0, // No significant risk.
+      MR_ELEVATED, // Cold surfaces approaching mould-risk RH%; setbacks limited.
+      MR_MOULD, // Cold surfaces at/above ~80% RH; mould growth possible if sustained.
+      MR_CONDENSATION // Cold surfaces at/below dew point; condensation likely.
+      };
+
+    // Assumed depression of a cold surface below room air temperature at the sensor (C*16), non-negative.
+    // ~3C is typical of a poorly-insulated external wall corner in UK winter.
+    static const int16_t COLD_SURFACE_DELTA_C16 = 3*16;
+    // Margin of surface above dew point (C*16) corresponding to ~80% surface RH at typical room temperatures.
+    static const int16_t MOULD_MARGIN_C16 = 56; // ~3.5C.
+    // Extra margin above the mould threshold at which risk is flagged as elevated (C*16).
+    static const int16_t ELEVATED_EXTRA_C16 = 2*16;
+    // Hysteresis required to drop to a lower risk level (C*16).
+    static const int16_t HYST_C16 = 8; // 0.5C.
+
+    // Compute dew point (C*16) from temperature (C*16) and RH% [0,100] using a fixed-point Magnus approximation.
+    // Within ~0.3C of the floating-point formula for 0--35C and 30--100% RH; RH% below 10 is treated as 10.
+    // Stateless and exposed for unit testing.
+    static int16_t computeDewPointC16(int16_t tempC16, uint8_t rh);
+
+  private:
+    // Last computed dew point (C*16); valid only if risk has been computed.
+    int16_t dewPointC16;
+    // Current risk level, with hysteresis.
+    uint8_t risk;
+
+  public:
+    MouldRiskEstimator() : dewPointC16(0), risk(MR_NONE) { }
+
+    // Update the estimate from fresh temperature (C*16) and RH% values; call once per minute or so.
+    // If the RH% is not available then the risk is cleared.
+    // Returns the new risk level.
+    uint8_t update(int16_t tempC16, uint8_t rh, bool rhAvailable);
+
+    // Get the current risk level (risk_t) in range [0,3].
+    uint8_t get() const { return(risk); }
+
+    // Returns a suggested (JSON) tag/field/key name for get(); not NULL.
+    const char *tag() const { return("mR"); }
+
+    // Get the last-computed dew point (C*16).
+    int16_t getDewPointC16() const { return(dewPointC16); }
+
+    // Get minimum room air temperature (whole C, rounded up) to avoid mould risk at cold surfaces,
+    // or 0 if no floor is currently required (ie risk level is MR_NONE).
+    uint8_t getFloorC() const;
+  };
+// Singleton implementation/instance.
+extern MouldRiskEstimator MouldRisk;
+#endif // defined(HUMIDITY_SENSOR_SUPPORT)
+
 
 #ifdef ENABLE_VOICE_SENSOR
 // TODO
@@ -136,6 +202,53 @@ extern OTRadValve::ValveMotorDirectV1<MOTOR_DRIVE_ML, MOTOR_DRIVE_MR, MOTOR_DRIV
 #else
 extern OTRadValve::ValveMotorDirectV1<MOTOR_DRIVE_MR, MOTOR_DRIVE_ML, MOTOR_DRIVE_MI_AIN, MOTOR_DRIVE_MC_AIN> ValveDirect;
 #endif // HAS_DORM1_MOTOR_REVERSED
+
+// Dead-reckoning model of the DORM1 valve position between end-stop calibrations,
+// sitting between the modelled valve target and ValveDirect to minimise motor run time.
+// Small pending moves are held back until they add up to something worthwhile,
+// where "worthwhile" grows with the estimated position error (a move smaller than the error achieves little).
+// Moves to the ends of travel (which re-reference the position against the end stop),
+// across the really-open threshold, or when a fast response is wanted, are passed through at once.
+// Estimated error grows with each move (spin-up/coast plus a fraction of travel)
+// and a recalibration is requested only once it grows too large.
+class ValveDeadReckoning
+  {
+  public:
+    // Minimum batched move (%) in normal operation; strictly positive.
+    static const uint8_t MIN_MOVE_PC = 4;
+    // Fixed error added per move (% * 16), eg from motor spin-up and coast.
+    static const uint8_t ERR_PER_MOVE_PC16 = 16; // 1%.
+    // Proportional error added per move as a right shift of travel (% * 16), ie ~1.6% of travel.
+    static const uint8_t ERR_TRAVEL_SHIFT = 6;
+    // Estimated error (% * 16) beyond which a recalibration is due.
+    static const uint16_t RECAL_ERR_PC16 = 15*16;
+
+  private:
+    // Position last handed to the driver [0,100].
+    uint8_t committedPC;
+    // Estimated position error (% * 16) accumulated since last end-stop contact or recalibration.
+    uint16_t errPC16;
+
+  public:
+    ValveDeadReckoning() : committedPC(0), errPC16(0) { }
+
+    // Given the new target [0,100], return the position to hand to the driver.
+    //   * minReallyOpenPC  really-open threshold; crossing it is never deferred
+    //   * urgent  if true, pass any change through immediately, eg while the user is adjusting controls
+    uint8_t update(uint8_t targetPC, uint8_t minReallyOpenPC, bool urgent);
+
+    // Get the estimated position error (whole %, rounded up).
+    uint8_t getErrorPC() const { return((uint8_t)OTV0P2BASE::fnmin((errPC16 + 15) >> 4, 100)); }
+
+    // True if the estimated error is large enough to justify a recalibration.
+    bool isRecalibrationDue() const { return(errPC16 >= RECAL_ERR_PC16); }
+
+    // Call when the driver has been recalibrated against the end stops.
+    void recalibrated() { errPC16 = 0; }
+  };
+// Singleton implementation/instance.
+extern ValveDeadReckoning ValveDirectDR;
+
 #endif
 
 